@@ -4,15 +4,29 @@
 //     (The new version of regina_file has no "[" at the line beginnings.)      //
 //                                                                              //
 // This program is designed to display cumulative data for Aliquot sequences.   //
-// The program relies on a file named "regina_file" which must be retrieved and //
-// unpacked from this file: regina_file.tar.lzma.  The file can be retrieved    //
-// from this site: http://www.aliquotes.com/aliquote_base.htm#alibasefonda      //
+// The program relies on a file named "regina_file" which comes packed in this  //
+// file: regina_file.tar.lzma.  The file can be retrieved from this site:       //
+// http://www.aliquotes.com/aliquote_base.htm#alibasefonda                      //
+// It does not need to be unpacked.  The archive (or any .xz file) can be given //
+// as the filename and is decompressed while it is read, and if regina_file is  //
+// missing, regina_file.tar.lzma is read in its place.                          //
 // The accuracy of this program is dependent on the currency of regina_file.    //
 //                                                                              //
-// To retrieve cycle information, the program has to access factordb.com, so a  //
-// network connection is also necessary.  If no network is available, cycle     //
-// data will show as blank.  wget must also be installed, which is commonly     //
-// available on most linux platforms.                                           //
+// Cycle information is worked out locally; no network connection is needed.    //
+// Each cycle entry point in the file is followed round its cycle by summing    //
+// divisors (with GMP), and the catalog of cycles is kept in the snapshot.      //
+//                                                                              //
+// After the first read of a file, a binary snapshot of it is saved alongside   //
+// as <filename>.snap.  Later runs load the snapshot instead, which is much     //
+// faster.  It is rebuilt automatically whenever the source file changes and    //
+// can be deleted at any time.                                                  //
+//                                                                              //
+// Changed sequences can be listed in <filename>.update as regina_file lines.   //
+// The "u" command appends to it, and lines can be added by hand.  The file     //
+// is applied on top of the data at startup, a later line for a sequence        //
+// replacing an earlier one, and once enough lines have built up they are       //
+// folded into a new snapshot.  Only ever add to the file; if it is changed     //
+// any other way, the data is read again from the source file.                  //
 //                                                                              //
 // A "results.txt" file can be used to capture the output of various data sets. //
 // This file is never deleted or overwritten by the program.  It only appends   //
@@ -27,299 +41,4252 @@
 // of columns not equal to 0 (mod 10) will not be aligned properly.  The        //
 // default for (y/n/f/c) is n.  "c" only provides the total count.              //
 //                                                                              //
-// Compile with "g++ <filename> -o <program name>"                              //
+// Command line: <program name> [options] [filename]                            //
+// filename defaults to regina_file.  --threads N sets how many cores are used  //
+// to load the file and run advanced searches; the default is every core.       //
+// Advanced filters use the widest vector instructions the processor has        //
+// (avx512, avx2 or scalar); --simd can ask for a narrower set.  --stats (or    //
+// --stats=json) writes the time spent loading, searching and listing, with     //
+// counts of rows, bytes read and allocations and the peak memory use, to       //
+// stderr as the program ends; the stats command shows the same at the prompt.  //
+//                                                                              //
+// Batch mode: --query "elB=0 and elC>=500 and elR<1.01" runs one search with   //
+// no prompts, and --queries <file> runs one search per line of the file (#     //
+// starts a comment).  Conditions are joined with "and" and compare elB..elT    //
+// (not elD) or seq with =, <, <=, > or >=; seq%b=a keeps a (mod b).            //
+// --range c:d and --mod a:b apply to every query.  Matches are written to      //
+// stdout, or to the file named by --output; --count writes only the number of  //
+// matches.  --format lays the matches out one per line (lines, the default),   //
+// comma or tab separated on one line (csv, tsv) or as binary: for each query   //
+// an 8 byte count and then 4 byte sequence numbers, little endian, with no     //
+// text.  Progress messages go to stderr.                                       //
+//                                                                              //
+// Server mode: --serve <socket> loads the file once and answers requests from  //
+// any number of clients over a Unix socket, --threads requests at a time,      //
+// until SIGINT or SIGTERM, which removes the socket.                           //
+// <program name> --client <socket> [request] sends one request, or one per     //
+// line of stdin, and prints the replies.  The requests are "seq N",            //
+// "prime P", "merge N", "cycle N", "query <conditions>" and                    //
+// "count <conditions>", with conditions as in batch mode.                      //
+//                                                                              //
+// Revision diff: --diff <old> <new> compares two revisions of regina_file      //
+// without loading either one.  Each sequence that differs gets a line listing  //
+// the fields that changed as "elX old>new" (or "added" or "removed"), followed //
+// by the number of changes per field and of sequences whose ending changed.    //
+// The files are streamed on --threads cores in a bounded amount of memory, and //
+// the listing goes to stdout or to the file named by --output.                 //
+//                                                                              //
+// Benchmarks: --gen-synthetic <rows> <file> writes a synthetic regina_file of  //
+// that many sequences, the same on every run, and --bench [filename] times     //
+// loading, p## lookups, merge listings, advanced searches and the prime census //
+// on it.  Each result is a tab separated line on stdout, so runs of two builds //
+// can be compared.                                                             //
+//                                                                              //
+// Compile with                                                                 //
+//     "g++ -O2 -pthread <filename> -o <program name> -lgmpxx -lgmp -llzma"     //
 //////////////////////////////////////////////////////////////////////////////////
 #include <iostream>
 #include <fstream>
 #include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include <gmpxx.h>
+#include <lzma.h>
 
 using namespace std;
 
-// structure for the first elements
-struct seqdata{
-//    int elA;  // ** Not used - index equals sequence **
-    int elB;  // <0=cycle, 0=open ended, 1=prime
-    int elC;  //  number of terms at sequence end or 10^50
-    string elD;  // for elB=<0,0,1: equals cycle entry term, smallest sequence for merges, terminating prime
-    int elE;  // ** Not currently used - value computed by program **
-    int elF;  // number of digits for largest term reached (up to 10^50 for open-ended)
-    int elG;  // number of relative minimums
-    int elH;  // number of relative maximums
-    int elI;  // number of parity changes
-    int elJ;  // record number of consecutive even abundant terms
-    int elK;  // record number of consecutive even deficient terms
-    int elL;  // record number of consecutive odd deficient terms
-    int elM;  // record number of consecutive odd abundant terms
-    int elN;  // number of downdriver extracts
-    bool ulist;  // used for advanced searches of results lists
+// field numbers of a regina_file line, elB through elT in file order (elA is
+// the sequence number itself and is not stored)
+enum{colB, colC, colD, colE, colF, colG, colH, colI, colJ, colK, colL, colM, colN, colO, colP, colQ, colR, colS, colT, ncols};
+
+// byte width of each column of a seqtable (elD holds dictionary ids)
+const int colwidth[ncols]={1, 2, 4, 4, 1, 2, 2, 2, 2, 2, 2, 2, 2, 8, 8, 8, 8, 8, 8};
+
+// size of a transparent huge page, the alignment used for large table arenas
+const uint64_t hugepage=2<<20;
+
+// structure for one line of regina_file as parsed, before it is narrowed
+// into a seqtable row
+struct seqrow{
+    int ints[colO];  // elB..elN by field number (ints[colD] is unused)
+    const char *elD;  // elD, left in place in the source text
+    size_t elDlen;  // length of elD
+    double dbls[ncols-colO];  // elO..elT
 };
 
-// structure for the precision elements - only used because the final couple of elements
-// overran the other structure's size capability
-struct seqdatad{
-    double elO;  // smallest quotient of two consecutive terms
-    double elP;  // largest quotient of two consecutive terms
-    double elQ;  // arithmetic mean of all quotients of two consecutive terms
-    double elR;  // geometric mean of all quotients of two consecutive terms
-    double elS;  // arithmetic mean of the number of digits of all the minimums of the sequence
-    double elT;  // arithmetic mean of the number of digits of all the maximums of the sequence
+// structure for the sequence ending counters of a block of regina_file
+struct endcounts{
+    int pcount;  // sequences that end with a prime
+    int ccount;  // sequences that end in a cycle
+    int ocount;  // open ended sequences
+};
+
+// structure for the values that did not fit their column
+// A value outside the range of its narrowed column (elB outside -128..127, a
+// negative elE, elF above 255, elC or elG..elN above 65535) is stored as the
+// nearest value that fits, and counted here so the loss can be reported.
+struct clampcounts{
+    uint32_t count[ncols];  // values clamped in each column
+    uint32_t first[ncols];  // lowest sequence with a clamped value in each column, 0 if none
+};
+
+// structure for a read-only view of an input file
+struct filemap{
+    const char *data;  // file contents
+    size_t size;  // number of bytes in data
+    bool mapped;  // true if data is mmapped, false if it was read into a heap buffer
+};
+
+// structure for the distinct elD values of a table
+// elD only takes a comparatively small number of values (terminal primes,
+// merge targets, cycle entries), so each value is stored once and rows hold
+// its 32 bit id.  Value k is chars[off[k]] up to chars[off[k+1]]; both arrays
+// either point into a mapped snapshot or at the vectors below.
+struct eldict{
+    uint32_t count;  // number of distinct values
+    const char *chars;  // characters of all values, back to back
+    const uint64_t *off;  // count+1 offsets into chars
+    string ownchars;  // storage for chars when not mapped
+    vector<uint64_t> ownoff;  // storage for off when not mapped
+    unordered_map<string_view, uint32_t> ids;  // value to id, filled by dictfind()
+};
+
+// structure for the inverted index from elD to the sequences that have it
+// The sequences whose elD has dictionary id k are seqs[start[k]] up to
+// seqs[start[k+1]], in increasing order.  Built by buildindex() on first use.
+struct elDindex{
+    vector<uint32_t> start;  // dictionary count+1 offsets into seqs
+    vector<uint32_t> seqs;  // sequence numbers grouped by elD
+};
+
+// structure for the sorted index of one numeric column
+// rows holds sequences 2 and up whose value is not NaN, in increasing order of
+// value and then of sequence, so the sequences with values in a range form one
+// run of rows.  A NaN passes every range, so those sequences are kept apart in
+// nans and added to every run.  Built by buildcolindex() the first time a
+// search uses it.
+struct colindex{
+    bool built;  // rows has been filled
+    vector<uint32_t> rows;  // sequences sorted by value
+    vector<uint32_t> nans;  // sequences whose value is NaN, in increasing order
+};
+
+// structure for the catalog of cycles that sequences of a table end in
+// Cycle k has members start[k] up to start[k+1], listed in aliquot order from
+// the first entry point met in the file.  Member m is the decimal value
+// chars[off[m]] up to chars[off[m+1]].  The arrays either point into a mapped
+// snapshot or at the vectors below.
+struct cyclecatalog{
+    uint32_t count;  // number of cycles
+    uint32_t members;  // number of members of all cycles
+    const uint32_t *start;  // count+1 offsets into the members
+    const uint64_t *off;  // members+1 offsets into chars
+    const char *chars;  // characters of all members, back to back
+    vector<uint32_t> ownstart;  // storage for start when not mapped
+    vector<uint64_t> ownoff;  // storage for off when not mapped
+    string ownchars;  // storage for chars when not mapped
+    unordered_map<string_view, uint32_t> ids;  // value to member, filled by cyclefind()
+};
+
+// structure for the zone maps of a table
+// Rows are grouped into zones of zonerows rows (zone z holds rows z*zonerows
+// onwards) and the smallest and largest value of every numeric column is kept
+// per zone, so a search can pass over zones that cannot hold a match.  NaN
+// values are left out of the ranges and flagged instead, since a NaN passes
+// every range.  Entry z*ncols+k belongs to column k of zone z; a zone with no
+// usable values has min=+inf and max=-inf.  The arrays either point into a
+// mapped snapshot or at the vectors below.
+const int zonerows=65536;
+struct zonemaps{
+    int count;  // number of zones
+    const double *min;  // smallest value of each column in each zone
+    const double *max;  // largest value of each column in each zone
+    const uint8_t *nan;  // 1 if the column has a NaN in the zone
+    vector<double> ownmin;  // storage for min when not mapped
+    vector<double> ownmax;  // storage for max when not mapped
+    vector<uint8_t> ownnan;  // storage for nan when not mapped
+};
+
+// structure for the value histograms of a table
+// The values of each numeric column, NaN excepted, are counted in histbins
+// equal bins between the edges lo[k] and hi[k] set by histedges() when the
+// table is summarised.  The edges stay fixed as rows are replaced, so the
+// bins keep their meaning.  Used to estimate how many sequences a range will
+// pass.  count either points into a mapped snapshot or at own.
+const int histbins=256;
+struct histograms{
+    const uint32_t *count;  // count[k*histbins+j]: sequences of column k in bin j
+    double lo[ncols];  // lower edge of the bins of each column
+    double hi[ncols];  // upper edge of the bins of each column
+    vector<uint32_t> own;  // storage for count when not mapped
+};
+
+// structure for the sequence data, stored as one contiguous array per field
+// Row i holds sequence i (rows 0 and 1 are unused), and each array uses the
+// narrowest type that holds its field, so a scan over one field only reads
+// that field's bytes.  The numeric arrays either share one allocation made by
+// newtable() or point straight into a mapped snapshot.
+struct seqtable{
+    int seqscount;  // one past the last sequence held
+    int8_t *elB;  // <0=cycle, 0=open ended, 1=prime
+    uint16_t *elC;  //  number of terms at sequence end or 10^50
+    uint32_t *elD;  // for elB=<0,0,1: equals cycle entry term, smallest sequence for merges, terminating prime (dictionary id)
+    uint32_t *elE;  // ** Not currently used - value computed by program **
+    uint8_t *elF;  // number of digits for largest term reached (up to 10^50 for open-ended)
+    uint16_t *elG;  // number of relative minimums
+    uint16_t *elH;  // number of relative maximums
+    uint16_t *elI;  // number of parity changes
+    uint16_t *elJ;  // record number of consecutive even abundant terms
+    uint16_t *elK;  // record number of consecutive even deficient terms
+    uint16_t *elL;  // record number of consecutive odd deficient terms
+    uint16_t *elM;  // record number of consecutive odd abundant terms
+    uint16_t *elN;  // number of downdriver extracts
+    double *elO;  // smallest quotient of two consecutive terms
+    double *elP;  // largest quotient of two consecutive terms
+    double *elQ;  // arithmetic mean of all quotients of two consecutive terms
+    double *elR;  // geometric mean of all quotients of two consecutive terms
+    double *elS;  // arithmetic mean of the number of digits of all the minimums of the sequence
+    double *elT;  // arithmetic mean of the number of digits of all the maximums of the sequence
+    struct endcounts ends;  // sequence ending counters
+    struct clampcounts clamps;  // values that did not fit their column
+    double colmin[ncols];  // smallest value of each numeric column (rows 2 and up)
+    double colmax[ncols];  // largest value of each numeric column (rows 2 and up)
+    struct eldict dict;  // values of elD
+    struct elDindex inv;  // sequences by elD
+    struct cyclecatalog cycles;  // members of the cycles sequences end in
+    struct zonemaps zones;  // column ranges per zone of rows
+    struct histograms hist;  // value histogram of each numeric column
+    struct colindex sorted[ncols];  // sorted index of each numeric column
+    bool frozen;  // shared between threads, so nothing more is built on use
+    uint64_t overlaid;  // bytes of <filename>.update already applied
+    uint64_t overlayhash;  // samplehash() of those bytes
+    char *arena;  // numeric column storage from newtable(), NULL if mapped
+    struct filemap snap;  // snapshot the numeric columns point into, if any
+};
+
+// structure for the header of a snapshot file
+// A snapshot is written next to regina_file as <filename>.snap and holds the
+// columns of a seqtable exactly as they are laid out in memory, followed by
+// the zone maps, the histograms, the elD dictionary and the cycle catalog.
+// Rows from the update file (see applyoverlay()) can be folded in, and the
+// header records how much of it, so only later additions are applied on top.  Every array starts
+// on a 64 byte boundary so the columns can be used in place.  The
+// snapshot is only used while the size, modification time and sampled hash of
+// the source still match.
+const uint32_t snapversion=11;
+const int compactrows=4096;  // pending update rows that call for a new snapshot
+struct snapheader{
+    char magic[8];  // "SEQSNAP"
+    uint32_t version;  // snapversion of the writer
+    uint32_t seqscount;  // number of rows, including the unused rows 0 and 1
+    uint64_t srcsize;  // size of the source file
+    int64_t srcmtime;  // modification time of the source file in ns
+    uint64_t srchash;  // samplehash() of the source file
+    uint32_t pcount;  // sequences that end with a prime
+    uint32_t ccount;  // sequences that end in a cycle
+    uint32_t ocount;  // open ended sequences
+    struct clampcounts clamps;  // values that did not fit their column
+    uint32_t dictcount;  // number of distinct elD values
+    uint64_t coloff[ncols];  // file offsets of the elB..elT arrays
+    double colmin[ncols];  // smallest value of each numeric column
+    double colmax[ncols];  // largest value of each numeric column
+    uint64_t zoneoff;  // file offset of the zone minimums, followed by the maximums and NaN flags
+    uint64_t histoff;  // file offset of the column histograms
+    double histlo[ncols];  // lower histogram edge of each numeric column
+    double histhi[ncols];  // upper histogram edge of each numeric column
+    uint64_t dictoff;  // file offset of dictcount+1 string offsets
+    uint64_t charoff;  // file offset of the dictionary characters
+    uint32_t cyclecount;  // number of cycles in the catalog
+    uint32_t cyclemembers;  // number of members of all cycles
+    uint64_t cstartoff;  // file offset of cyclecount+1 member offsets
+    uint64_t coffoff;  // file offset of cyclemembers+1 string offsets
+    uint64_t ccharoff;  // file offset of the cycle member characters
+    uint64_t overlaysize;  // bytes of <filename>.update folded into the snapshot
+    uint64_t overlayhash;  // samplehash() of those bytes
+    uint64_t filesize;  // size of the whole snapshot
 };
 
-// Routine to update all open-ended sequences
-// This function does not change the original regina_file, but provides an
-// additional file that updates the program data when it is run.
-void createupdate(struct seqdata seqd[]){
-    cout << "Update file routine not available yet!" << endl;
+
+// phases of a session timed for the stats command
+enum{phaseload, phasesnapshot, phaseoverlay, phasesave, phaseindex, phasesearch, phasecensus, phaselisting, nphases};
+const char *const phasenames[nphases]={"load", "snapshot", "overlay", "save", "index", "search", "census", "listing"};
+
+// structure for the running totals behind the stats command and --stats
+// Every field is a relaxed atomic, so the worker threads add to it freely;
+// counters are added once per block or per listing rather than per row.
+struct perfstats{
+    atomic<uint64_t> ns[nphases];  // time spent in each phase
+    atomic<uint64_t> calls[nphases];  // times each phase was run
+    atomic<uint64_t> scanned;  // rows examined by searches and listings
+    atomic<uint64_t> matched;  // rows they found
+    atomic<uint64_t> bytesread;  // bytes of input read
+    atomic<uint64_t> allocs;  // calls to operator new
+    atomic<uint64_t> allocbytes;  // bytes asked of operator new
+};
+struct perfstats perf;
+
+// Routine to allocate memory, counting the allocation
+void *operator new(size_t n){
+    void *p;
+
+    perf.allocs.fetch_add(1, memory_order_relaxed);
+    perf.allocbytes.fetch_add(n, memory_order_relaxed);
+    p=malloc((n>0) ? n : 1);
+    if(p==NULL)
+        throw bad_alloc();
+
+    return p;
+}
+
+// Routine to release memory from operator new
+// Kept out of line, or gcc takes the free() of memory from new for a mismatch.
+__attribute__((noinline)) void operator delete(void *p) noexcept{
+    free(p);
 
     return;
 }
 
-// Routine to display help information
-void helptext(){
-    cout << "--Available options for the following prompts--" << endl;
-    cout << "(##/a/h/p/p##/q/u): prompt" << endl;
-    cout << "    ## displays info for sequence ## if it is within the range." << endl;
-    cout << "    a brings up an advanced input routine." << endl;
-    cout << "    h provides this text block." << endl;
-    cout << "    p lists counts of all primes that terminate" << endl;
-    cout << "      a sequence within the limit of regina_file." << endl;
-    cout << "      This will take a long time to complete." << endl;
-    cout << "      Due to the large return count, the list is" << endl;
-    cout << "      sent to a primescount.txt file.  This file is" << endl;
-    cout << "      overwritten with each run." << endl;
-    cout << "    p## searches for sequences that terminate with the prime ##." << endl;
-    cout << "    u (not available yet!) run a routine to make a file of updates." << endl;
-    cout << "      The file OE_3000000_C80.txt must be available." << endl;
-    cout << "      This will take a long time.  If the file exists" << endl;
-    cout << "      it will be overwritten with a new file." << endl;
-    cout << "(y/n/c/f): prompt" << endl;
-    cout << "    y performs the procedure referenced." << endl;
-    cout << "    n negative response. (default if an entry is omitted, except for Advanced)" << endl;
-    cout << "    c provides a count only, without a listing." << endl;
-    cout << "    f provides a listing to screen and to results.txt." << endl;
-    cout << "      (results.txt is never removed by the program." << endl;
-    cout << "      It is only appended to.  It has to be manually deleted.)" << endl;
+// Routine to release memory from operator new, given its size
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept{
+    free(p);
+
     return;
 }
 
-// Routine to list and count all prime terminations for entire regina_file range
-void primeslist(struct seqdata seqd[], int seqscount){
-    ofstream pout;
-    static string plist[2000000];
-    static int plcount[2000000];
-    string ptemp, yn;
-    int check, pcount=0, i, j, ptempi;
-    bool exists;
-
-    cout << "This process will take several hours.  Continue? (y/n):";
-    getline (cin, yn);
-    if(yn.substr(0.1)=="y"){
-        auto start = std::chrono::system_clock::now();
-
-        for(i=2;i<seqscount;i++){
-            if(i%1000==0){
-                cout << "  Progress: " << (i*100)/seqscount << "%\r";
-                fflush(stdout);
-            }
-            if(seqd[i].elB==1){
-                exists=false;
-                for(j=0;j<pcount;j++){
-                    if(seqd[i].elD==plist[j]){
-                        exists=true;
-                        plcount[j]++;
-                    }
-                }
-                if(exists==false){
-                    plist[pcount]=seqd[i].elD;
-                    plcount[pcount]=1;
-                    pcount++;
-                }
-            }
-        }
+// Routine to note the start of a timed phase
+// Returns the time in ns, to be handed to phaseend().
+uint64_t phasestart(){
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-        for(i=0;i<pcount-1;i++){
-            for(j=1;j<pcount;j++){
-                check=plist[j-1].compare(plist[j]);
-                if(check>0){
-                    ptemp.assign(plist[j-1]);
-                    plist[j-1].assign(plist[j]);
-                    plist[j].assign(ptemp);
-                    ptempi=plcount[j-1];
-                    plcount[j-1]=plcount[j];
-                    plcount[j]=ptempi;
-                }
-                if(plist[j-1].length()>plist[j].length()){
-                    ptemp.assign(plist[j-1]);
-                    plist[j-1].assign(plist[j]);
-                    plist[j].assign(ptemp);
-                    ptempi=plcount[j-1];
-                    plcount[j-1]=plcount[j];
-                    plcount[j]=ptempi;
-                }
-            }
-        }
+// Routine to add the time since start to a phase
+void phaseend(int phase, uint64_t start){
+    perf.ns[phase].fetch_add(phasestart()-start, memory_order_relaxed);
+    perf.calls[phase].fetch_add(1, memory_order_relaxed);
 
-        pout.open("primescount.txt");
-        if(pout.is_open()){
-            for(i=0;i<pcount;i++){
-                pout << plist[i] << ": " << plcount[i] << endl;
-            }
-            pout.close();
-            pout << pcount << " unique primes found!" << endl;
+    return;
+}
+
+// Routine to write the phase times and counters of the session so far
+// json gives one JSON object on one line for scripts; otherwise a table.
+void statsreport(ostream &os, bool json){
+    struct rusage ru;
+    char line[256];
+    int p;
+
+    getrusage(RUSAGE_SELF, &ru);
+    if(json==true){
+        os << "{\"phases\":{";
+        for(p=0;p<nphases;p++){
+            snprintf(line, sizeof(line), "%s\"%s\":{\"calls\":%llu,\"ms\":%.3f}", (p>0) ? "," : "", phasenames[p], (unsigned long long)perf.calls[p].load(), perf.ns[p].load()/1e6);
+            os << line;
         }
-        else
-            cout << "primescount.txt did not open properly!" << endl;
+        os << "},\"rows_scanned\":" << perf.scanned.load() << ",\"rows_matched\":" << perf.matched.load();
+        os << ",\"bytes_read\":" << perf.bytesread.load() << ",\"allocations\":" << perf.allocs.load();
+        os << ",\"allocated_bytes\":" << perf.allocbytes.load() << ",\"peak_rss_kb\":" << ru.ru_maxrss << "}" << endl;
+        return;
+    }
+    os << "Phase          calls           ms" << endl;
+    for(p=0;p<nphases;p++){
+        snprintf(line, sizeof(line), "%-10s %9llu %12.1f", phasenames[p], (unsigned long long)perf.calls[p].load(), perf.ns[p].load()/1e6);
+        os << line << endl;
+    }
+    os << "Rows scanned: " << perf.scanned.load() << ", matched: " << perf.matched.load() << endl;
+    os << "Bytes read: " << perf.bytesread.load() << endl;
+    os << "Allocations: " << perf.allocs.load() << " (" << perf.allocbytes.load() << " bytes)" << endl;
+    os << "Peak RSS: " << ru.ru_maxrss << " KB" << endl;
 
-        cout << pcount << " unique primes found!" << endl;
+    return;
+}
 
-        auto end = std::chrono::system_clock::now();
-        std::chrono::duration<double> elapsed = end - start;
-        cout << "Listing took " << int(elapsed.count()+.5) << " seconds to generate." << endl;
+// Routine to write the --stats=json report as the program exits
+void statsjson(){
+    statsreport(cerr, true);
 
-    }
+    return;
+}
+
+// Routine to write the --stats report as the program exits
+void statstext(){
+    statsreport(cerr, false);
 
     return;
 }
 
-// Routine to perform advanced searches of data
-void advanced(struct seqdata seqd[], struct seqdatad seqdd[], int seqscount, bool uselist){
-    ofstream aout;
-    string sf1, sf2, sf3, temp, yn;
-    char *dp;
-    size_t found;
-    int i, a, b, c, d, e, f, g, h, j, k, l, m, n, o, p, q, r, s, t, u, v, w, x, rcount;
-    double da, db, dc, dd, de, df, dg, dh, di, dj, dk, dl;
-    bool crlf, show;
+// Routine to open a file as a read-only memory map
+// Anything that cannot be mapped (pipes, special files) is read into memory instead.
+bool openmap(string name, struct filemap &fm){
+    struct stat st;
+    char *buf;
+    size_t cap, len;
+    ssize_t got;
+    int fd;
 
-    if(uselist==true)
-        cout << "Advanced Routine using previous results" << endl;
-    else
-        cout << "Advanced Routine" << endl;
-    cout << "Sequence filter a (mod b) (a b): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            a=atoi(temp.substr(0,found).c_str());
-            b=atoi(temp.substr(found+1).c_str());
+    fm.data=NULL;
+    fm.size=0;
+    fm.mapped=false;
+    fd=open(name.c_str(), O_RDONLY);
+    if(fd<0)
+        return false;
+    if(fstat(fd, &st)==0 && S_ISREG(st.st_mode)){
+        if(st.st_size==0){
+            close(fd);
+            return true;
         }
-        else{
-            a=0;
-            b=atoi(temp.c_str());
+        void *m=mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(m!=MAP_FAILED){
+            madvise(m, st.st_size, MADV_SEQUENTIAL);
+            fm.data=(const char *)m;
+            fm.size=st.st_size;
+            fm.mapped=true;
+            close(fd);
+            return true;
         }
     }
-    else{
-        a=0;
-        b=1;
-    }
-    if(a<0)
-        a=0;
-    if(b>seqscount-1)
-        b=seqscount-1;
-    cout << "Sequence range (begin end): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            c=atoi(temp.substr(0,found).c_str());
-            d=atoi(temp.substr(found+1).c_str());
-        }
-        else{
-            c=atoi(temp.c_str());
-            d=c;
+    cap=1<<20;
+    len=0;
+    buf=(char *)malloc(cap);
+    while(buf!=NULL && (got=read(fd, buf+len, cap-len))>0){
+        len+=got;
+        if(len==cap){
+            cap*=2;
+            buf=(char *)realloc(buf, cap);
         }
     }
-    else{
-        c=2;
-        d=seqscount-1;
-    }
-    if(c<2)
-        c=2;
-    if(d>seqscount-1)
-        d=seqscount-1;
-    cout << "All, Prime, Open, Cylce (a/p/o/c): ";
-    getline(cin, temp);
-    if(temp.substr(0,1)=="p")
-        e=1;
-    else if(temp.substr(0,1)=="o")
-        e=0;
-    else if(temp.substr(0,1)=="c")
-        e=-1;
+    close(fd);
+    if(buf==NULL)
+        return false;
+    fm.data=buf;
+    fm.size=len;
+    return true;
+}
+
+// Routine to release a file opened with openmap()
+void closemap(struct filemap &fm){
+    if(fm.mapped==true)
+        munmap((void *)fm.data, fm.size);
     else
-        e=2;
-    cout << "Range for number of iterations (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            w=atoi(temp.substr(0,found).c_str());
-            x=atoi(temp.substr(found+1).c_str());
-        }
-        else{
-            w=atoi(temp.c_str());
-            x=w;
-        }
+        free((void *)fm.data);
+    fm.data=NULL;
+    fm.size=0;
+}
+
+// structure for the tasks still owed to one thread of parallelfor()
+// Tasks next up to end belong to the thread; alignas keeps each on its own
+// cache line so the owners do not slow each other down.
+struct alignas(64) taskrange{
+    atomic<int> next;  // next task not yet claimed
+    int end;  // one past the last task of the range
+};
+
+// Routine to run ntasks tasks on a pool of nthreads threads
+// The tasks are dealt out as one contiguous range per thread, so neighbouring
+// tasks usually run on the same core.  A thread that finishes its own range
+// steals the remaining tasks of the others one at a time.  The calling thread
+// works as thread 0, so nthreads=1 runs everything in place.
+void parallelfor(int nthreads, int ntasks, const function<void(int, int)> &task){
+    vector<struct taskrange> ranges;
+    vector<thread> pool;
+    int i;
+
+    if(nthreads>ntasks)
+        nthreads=ntasks;
+    if(nthreads<=1){
+        for(i=0;i<ntasks;i++)
+            task(i, 0);
+        return;
     }
-    else{
-        w=0;
-        x=30000;
+    ranges=vector<struct taskrange>(nthreads);
+    for(i=0;i<nthreads;i++){
+        ranges[i].next=(int)((int64_t)ntasks*i/nthreads);
+        ranges[i].end=(int)((int64_t)ntasks*(i+1)/nthreads);
     }
-    if(w<0)
-        w=0;
-    cout << "Range for number of relative minimums (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            f=atoi(temp.substr(0,found).c_str());
-            g=atoi(temp.substr(found+1).c_str());
-        }
-        else{
-            f=atoi(temp.c_str());
-            g=f;
+    auto worker=[&](int tid){
+        int t, v;
+
+        for(v=0;v<nthreads;v++){
+            struct taskrange &r=ranges[(tid+v)%nthreads];
+            while((t=r.next.fetch_add(1))<r.end)
+                task(t, tid);
         }
+    };
+    for(i=1;i<nthreads;i++)
+        pool.emplace_back(worker, i);
+    worker(0);
+    for(i=0;i<(int)pool.size();i++)
+        pool[i].join();
+
+    return;
+}
+
+// Routine to return the array of numeric column c of a table
+void *colarray(struct seqtable &st, int c){
+    switch(c){
+        case colB: return st.elB;
+        case colC: return st.elC;
+        case colD: return st.elD;
+        case colE: return st.elE;
+        case colF: return st.elF;
+        case colG: return st.elG;
+        case colH: return st.elH;
+        case colI: return st.elI;
+        case colJ: return st.elJ;
+        case colK: return st.elK;
+        case colL: return st.elL;
+        case colM: return st.elM;
+        case colN: return st.elN;
+        case colO: return st.elO;
+        case colP: return st.elP;
+        case colQ: return st.elQ;
+        case colR: return st.elR;
+        case colS: return st.elS;
+        case colT: return st.elT;
     }
-    else{
-        f=0;
-        g=10000;
+    return NULL;
+}
+
+// Routine to return the value of numeric column c for sequence i
+double colvalue(struct seqtable &st, int c, int i){
+    switch(colwidth[c]){
+        case 1:
+            if(c==colB)
+                return st.elB[i];
+            return ((const uint8_t *)colarray(st, c))[i];
+        case 2:
+            return ((const uint16_t *)colarray(st, c))[i];
+        case 4:
+            return ((const uint32_t *)colarray(st, c))[i];
     }
-    if(f<0)
-        f=0;
-    cout << "Range for number of relative maximums (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            h=atoi(temp.substr(0,found).c_str());
-            j=atoi(temp.substr(found+1).c_str());
-        }
-        else{
-            h=atoi(temp.c_str());
-            j=h;
-        }
+    return ((const double *)colarray(st, c))[i];
+}
+
+// Routine to point the numeric columns of a table at consecutive 64 byte
+// aligned arrays starting at base, with column c at base+coloff[c]
+void setcolumns(struct seqtable &st, char *base, const uint64_t coloff[]){
+    st.elB=(int8_t *)(base+coloff[colB]);
+    st.elC=(uint16_t *)(base+coloff[colC]);
+    st.elD=(uint32_t *)(base+coloff[colD]);
+    st.elE=(uint32_t *)(base+coloff[colE]);
+    st.elF=(uint8_t *)(base+coloff[colF]);
+    st.elG=(uint16_t *)(base+coloff[colG]);
+    st.elH=(uint16_t *)(base+coloff[colH]);
+    st.elI=(uint16_t *)(base+coloff[colI]);
+    st.elJ=(uint16_t *)(base+coloff[colJ]);
+    st.elK=(uint16_t *)(base+coloff[colK]);
+    st.elL=(uint16_t *)(base+coloff[colL]);
+    st.elM=(uint16_t *)(base+coloff[colM]);
+    st.elN=(uint16_t *)(base+coloff[colN]);
+    st.elO=(double *)(base+coloff[colO]);
+    st.elP=(double *)(base+coloff[colP]);
+    st.elQ=(double *)(base+coloff[colQ]);
+    st.elR=(double *)(base+coloff[colR]);
+    st.elS=(double *)(base+coloff[colS]);
+    st.elT=(double *)(base+coloff[colT]);
+
+    return;
+}
+
+// Routine to lay out the numeric columns for rows rows from offset off on
+// Returns the offset just past the last column.
+uint64_t layoutcolumns(int rows, uint64_t off, uint64_t coloff[]){
+    int c;
+
+    for(c=0;c<ncols;c++){
+        off=(off+63)/64*64;
+        coloff[c]=off;
+        off+=(uint64_t)colwidth[c]*rows;
     }
-    else{
-        h=0;
-        j=10000;
+
+    return off;
+}
+
+// Routine to allocate an empty table for sequences 0 through rows-1
+// All fields start at zero.  The table is sized from the input alone; arenas
+// of a huge page or more are aligned to 2 MB and marked for transparent huge
+// pages, so a full-size file costs a few thousand TLB entries, not a million.
+bool newtable(struct seqtable &st, int rows){
+    uint64_t coloff[ncols], align, size;
+
+    st=seqtable();
+    size=layoutcolumns(rows, 0, coloff);
+    align=(size>=hugepage) ? hugepage : 64;
+    size=(size+align-1)/align*align;
+    st.arena=(char *)aligned_alloc(align, size);
+    if(st.arena==NULL)
+        return false;
+    if(align==hugepage)
+        madvise(st.arena, size, MADV_HUGEPAGE);
+    memset(st.arena, 0, size);
+    setcolumns(st, st.arena, coloff);
+    st.seqscount=rows;
+
+    return true;
+}
+
+// Routine to release a table made by newtable() or loadsnapshot()
+void freetable(struct seqtable &st){
+    if(st.arena!=NULL)
+        free(st.arena);
+    if(st.snap.data!=NULL)
+        closemap(st.snap);
+    st=seqtable();
+
+    return;
+}
+
+// Routine to resize a table made by newtable() to rows sequences
+// The rows both sizes share are kept.  Only the columns are carried over, so it
+// is meant for loaders that fill in the rest of the table afterwards.
+bool resizetable(struct seqtable &st, int rows){
+    struct seqtable grown;
+    int c, keep;
+
+    if(newtable(grown, rows)==false)
+        return false;
+    keep=(rows<st.seqscount) ? rows : st.seqscount;
+    for(c=0;c<ncols;c++)
+        memcpy(colarray(grown, c), colarray(st, c), (size_t)colwidth[c]*keep);
+    freetable(st);
+    st=grown;
+
+    return true;
+}
+
+// Routine to clamp a parsed value into the type of its column
+template<typename T>
+static inline T narrow(int v){
+    if(v<numeric_limits<T>::min())
+        return numeric_limits<T>::min();
+    if(v>numeric_limits<T>::max())
+        return numeric_limits<T>::max();
+    return (T)v;
+}
+
+// Routine to return the elD value with dictionary id id
+string_view dictvalue(const struct seqtable &st, uint32_t id){
+    return string_view(st.dict.chars+st.dict.off[id], st.dict.off[id+1]-st.dict.off[id]);
+}
+
+// Routine to find the dictionary id of an elD value
+// Returns -1 if no row has that value.  The lookup table is built on first use.
+int64_t dictfind(struct seqtable &st, string_view value){
+    uint32_t k;
+
+    if(st.dict.ids.size()==0 && st.dict.count>0){
+        st.dict.ids.reserve(st.dict.count);
+        for(k=0;k<st.dict.count;k++)
+            st.dict.ids.emplace(dictvalue(st, k), k);
     }
-    if(h<0)
-        h=0;
-    cout << "Range for number of parity changes (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            k=atoi(temp.substr(0,found).c_str());
-            l=atoi(temp.substr(found+1).c_str());
-        }
-        else{
-            k=atoi(temp.c_str());
-            l=k;
-        }
+    auto it=st.dict.ids.find(value);
+    if(it==st.dict.ids.end())
+        return -1;
+    return it->second;
+}
+
+// Routine to return the value of member m of the cycle catalog
+string_view cyclevalue(const struct seqtable &st, uint32_t m){
+    return string_view(st.cycles.chars+st.cycles.off[m], st.cycles.off[m+1]-st.cycles.off[m]);
+}
+
+// Routine to find the member of the cycle catalog with value value
+// Returns -1 if no cycle has that member.  The lookup table is built on first use.
+int64_t cyclefind(struct seqtable &st, string_view value){
+    uint32_t m;
+
+    if(st.cycles.ids.size()==0 && st.cycles.members>0){
+        st.cycles.ids.reserve(st.cycles.members);
+        for(m=0;m<st.cycles.members;m++)
+            st.cycles.ids.emplace(cyclevalue(st, m), m);
     }
-    else{
-        k=0;
-        l=10000;
+    auto it=st.cycles.ids.find(value);
+    if(it==st.cycles.ids.end())
+        return -1;
+    return it->second;
+}
+
+// Routine to return the cycle that member m of the cycle catalog belongs to
+uint32_t cycleof(const struct seqtable &st, uint32_t m){
+    return upper_bound(st.cycles.start, st.cycles.start+st.cycles.count+1, m)-st.cycles.start-1;
+}
+
+// Routine to find the smallest and largest values of part of a column
+// nan is set if a NaN is met.
+template<typename T>
+void colrange(const T *col, int from, int to, double &mn, double &mx, uint8_t &nan){
+    T lo, hi;
+    int i;
+
+    if(from>=to)
+        return;
+    lo=col[from];
+    hi=col[from];
+    for(i=from;i<to;i++){
+        if(col[i]!=col[i])
+            nan=1;
+        if(col[i]<lo || lo!=lo)
+            lo=col[i];
+        if(col[i]>hi || hi!=hi)
+            hi=col[i];
+    }
+    if(lo<mn)
+        mn=lo;
+    if(hi>mx)
+        mx=hi;
+
+    return;
+}
+
+// Routine to work out the edges of the histogram of numeric column c
+// The edges follow the column range.  Integer columns get half a unit of
+// room on each side, so every value falls squarely inside one bin.
+void histedges(const struct seqtable &st, int c, double &lo, double &hi){
+    lo=st.colmin[c];
+    hi=st.colmax[c];
+    if(colwidth[c]<8){
+        lo-=0.5;
+        hi+=0.5;
+    }
+
+    return;
+}
+
+// Routine to count the values of part of a column into histbins bins
+template<typename T>
+void colhist(const T *col, int from, int to, double lo, double hi, uint32_t *bins){
+    double scale=(hi>lo) ? histbins/(hi-lo) : 0;
+    int i, j;
+
+    for(i=from;i<to;i++){
+        if(col[i]!=col[i])
+            continue;
+        j=(int)((col[i]-lo)*scale);
+        if(j<0)
+            j=0;
+        if(j>=histbins)
+            j=histbins-1;
+        bins[j]++;
+    }
+
+    return;
+}
+
+// Routine to find the smallest and largest value of every numeric column
+// Each zone is summarised in parallel and kept as the table's zone maps, and
+// the zones are then combined.  A second pass over the zones fills the value
+// histograms, one set per thread, which are then added up.  NaN values are
+// ignored, apart from the zone flags.
+void columnstats(struct seqtable &st, int nthreads){
+    vector<double> &bmin=st.zones.ownmin, &bmax=st.zones.ownmax;
+    vector<uint8_t> &bnan=st.zones.ownnan;
+    vector<uint32_t> tbins;
+    double hlo[ncols], hhi[ncols];
+    int c, t, nblocks=(st.seqscount+zonerows-1)/zonerows;
+    size_t j;
+
+    bmin.assign((size_t)nblocks*ncols, numeric_limits<double>::infinity());
+    bmax.assign((size_t)nblocks*ncols, -numeric_limits<double>::infinity());
+    bnan.assign((size_t)nblocks*ncols, 0);
+    st.zones.count=nblocks;
+    st.zones.min=bmin.data();
+    st.zones.max=bmax.data();
+    st.zones.nan=bnan.data();
+    parallelfor(nthreads, nblocks, [&](int t, int){
+        int from=(t==0) ? 2 : t*zonerows, to=(t+1)*zonerows, k;
+        double *mn=&bmin[(size_t)t*ncols], *mx=&bmax[(size_t)t*ncols];
+        uint8_t *nan=&bnan[(size_t)t*ncols];
+
+        if(to>st.seqscount)
+            to=st.seqscount;
+        colrange(st.elB, from, to, mn[colB], mx[colB], nan[colB]);
+        colrange(st.elC, from, to, mn[colC], mx[colC], nan[colC]);
+        colrange(st.elE, from, to, mn[colE], mx[colE], nan[colE]);
+        colrange(st.elF, from, to, mn[colF], mx[colF], nan[colF]);
+        for(k=colG;k<=colN;k++)
+            colrange((const uint16_t *)colarray(st, k), from, to, mn[k], mx[k], nan[k]);
+        for(k=colO;k<=colT;k++)
+            colrange((const double *)colarray(st, k), from, to, mn[k], mx[k], nan[k]);
+    });
+    for(c=0;c<ncols;c++){
+        st.colmin[c]=numeric_limits<double>::infinity();
+        st.colmax[c]=-numeric_limits<double>::infinity();
+        for(t=0;t<nblocks;t++){
+            if(bmin[(size_t)t*ncols+c]<st.colmin[c])
+                st.colmin[c]=bmin[(size_t)t*ncols+c];
+            if(bmax[(size_t)t*ncols+c]>st.colmax[c])
+                st.colmax[c]=bmax[(size_t)t*ncols+c];
+        }
+        histedges(st, c, hlo[c], hhi[c]);
+        st.hist.lo[c]=hlo[c];
+        st.hist.hi[c]=hhi[c];
+    }
+    if(nthreads>nblocks)
+        nthreads=nblocks;
+    if(nthreads<1)
+        nthreads=1;
+    tbins.assign((size_t)nthreads*ncols*histbins, 0);
+    parallelfor(nthreads, nblocks, [&](int t, int tid){
+        int from=(t==0) ? 2 : t*zonerows, to=(t+1)*zonerows, k;
+        uint32_t *bins=&tbins[(size_t)tid*ncols*histbins];
+
+        if(to>st.seqscount)
+            to=st.seqscount;
+        colhist(st.elB, from, to, hlo[colB], hhi[colB], bins+colB*histbins);
+        colhist(st.elC, from, to, hlo[colC], hhi[colC], bins+colC*histbins);
+        colhist(st.elE, from, to, hlo[colE], hhi[colE], bins+colE*histbins);
+        colhist(st.elF, from, to, hlo[colF], hhi[colF], bins+colF*histbins);
+        for(k=colG;k<=colN;k++)
+            colhist((const uint16_t *)colarray(st, k), from, to, hlo[k], hhi[k], bins+k*histbins);
+        for(k=colO;k<=colT;k++)
+            colhist((const double *)colarray(st, k), from, to, hlo[k], hhi[k], bins+k*histbins);
+    });
+    st.hist.own.assign((size_t)ncols*histbins, 0);
+    for(t=0;t<nthreads;t++)
+        for(j=0;j<st.hist.own.size();j++)
+            st.hist.own[j]+=tbins[(size_t)t*ncols*histbins+j];
+    st.hist.count=st.hist.own.data();
+
+    return;
+}
+
+// Routine to build the inverted index of a table if it has not been built yet
+// A counting sort over the rows in sequence order, so each list comes out sorted.
+void buildindex(struct seqtable &st){
+    vector<uint32_t> next;
+    uint64_t start;
+    uint32_t k;
+    int i;
+
+    if(st.inv.start.size()>0)
+        return;
+    start=phasestart();
+    st.inv.start.assign(st.dict.count+1, 0);
+    for(i=2;i<st.seqscount;i++)
+        st.inv.start[st.elD[i]+1]++;
+    for(k=0;k<st.dict.count;k++)
+        st.inv.start[k+1]+=st.inv.start[k];
+    next.assign(st.inv.start.begin(), st.inv.start.end()-1);
+    st.inv.seqs.resize(st.inv.start[st.dict.count]);
+    for(i=2;i<st.seqscount;i++)
+        st.inv.seqs[next[st.elD[i]]++]=i;
+    phaseend(phaseindex, start);
+
+    return;
+}
+
+// Routine to find the sequences whose elD has dictionary id id
+// first is set to the start of the sorted list and its length is returned.
+size_t elDseqs(struct seqtable &st, uint32_t id, const uint32_t *&first){
+    buildindex(st);
+    first=st.inv.seqs.data()+st.inv.start[id];
+
+    return st.inv.start[id+1]-st.inv.start[id];
+}
+
+// Routine to list the primes below 65536, for trial division
+const vector<uint32_t> &smallprimes(){
+    static const vector<uint32_t> primes=[]{
+        vector<uint32_t> p;
+        vector<bool> composite(65536, false);
+        uint32_t i, j;
+
+        for(i=2;i<65536;i++){
+            if(composite[i]==true)
+                continue;
+            p.push_back(i);
+            for(j=i*i;j<65536;j+=i)
+                composite[j]=true;
+        }
+        return p;
+    }();
+
+    return primes;
+}
+
+// Routine to find a proper factor f of the composite n with Pollard's rho
+// Brent's variant, multiplying 128 differences together per gcd.  A few
+// polynomials are tried, each for up to limit steps.  Returns false if no
+// factor turned up.
+bool rhofactor(const mpz_class &n, mpz_class &f, uint64_t limit){
+    mpz_class x, y, ys, q, d;
+    uint64_t i, k, r;
+    unsigned long c;
+
+    for(c=1;c<=4;c++){
+        y=2;
+        q=1;
+        f=1;
+        for(r=1;f==1 && r<=limit;r*=2){
+            x=y;
+            for(i=0;i<r;i++){
+                y=y*y+c;
+                y%=n;
+            }
+            for(k=0;k<r && f==1;k+=128){
+                ys=y;
+                for(i=0;i<128 && i<r-k;i++){
+                    y=y*y+c;
+                    y%=n;
+                    d=x-y;
+                    q*=abs(d);
+                    q%=n;
+                }
+                f=gcd(q, n);
+            }
+        }
+        if(f==n){
+            // the batch overshot; step again one at a time from its start
+            do{
+                ys=ys*ys+c;
+                ys%=n;
+                d=x-ys;
+                f=gcd(abs(d), n);
+            }while(f==1);
+        }
+        if(f!=1 && f!=n)
+            return true;
+    }
+
+    return false;
+}
+
+// Routine to find a proper factor f of the composite n with Lenstra's
+// elliptic curve method
+// Each curve is a Montgomery curve from Suyama's parametrisation, worked in
+// X:Z coordinates.  Stage 1 multiplies the start point by every prime power up
+// to b1 and stage 2 catches one more prime up to 100*b1 with baby and giant
+// steps of 210.  curves curves are tried, starting from sigma=seed.  Returns
+// false if none of them found a factor.
+bool ecmfactor(const mpz_class &n, mpz_class &f, uint32_t b1, int curves, uint32_t seed){
+    const vector<uint32_t> &primes=smallprimes();
+    const uint64_t d=210;
+    vector<mpz_class> bx, bz, ox(d/2+1), oz(d/2+1);
+    mpz_class a24, x, z, u, v, t, inv, acc;
+    mpz_class gx, gz, hx, hz, sx, sz, nx, nz;
+    uint64_t b2=(uint64_t)b1*100, i, j, q;
+    size_t k;
+    int curve;
+
+    // doubling and differential addition on the curve
+    auto dbl=[&](const mpz_class &x1, const mpz_class &z1, mpz_class &x2, mpz_class &z2){
+        mpz_class s=(x1+z1)*(x1+z1)%n, e=(x1-z1)*(x1-z1)%n, w=s-e;
+
+        x2=s*e%n;
+        z2=w*((e+a24*w)%n)%n;
+    };
+    auto add=[&](const mpz_class &x1, const mpz_class &z1, const mpz_class &x2, const mpz_class &z2, const mpz_class &xd, const mpz_class &zd, mpz_class &x3, mpz_class &z3){
+        mpz_class s=(x1-z1)*(x2+z2)%n, e=(x1+z1)*(x2-z2)%n;
+
+        x3=zd*((s+e)*(s+e)%n)%n;
+        z3=xd*((s-e)*(s-e)%n)%n;
+    };
+    // Montgomery ladder: (x, z) becomes m times itself
+    auto ladder=[&](mpz_class &x1, mpz_class &z1, uint64_t m){
+        mpz_class r0x=x1, r0z=z1, r1x, r1z, tx, tz;
+        int b;
+
+        if(m<2)
+            return;
+        dbl(x1, z1, r1x, r1z);
+        for(b=62-__builtin_clzll(m);b>=0;b--){
+            if((m>>b)&1){
+                add(r0x, r0z, r1x, r1z, x1, z1, tx, tz);
+                dbl(r1x, r1z, r1x, r1z);
+                r0x=tx;
+                r0z=tz;
+            }
+            else{
+                add(r0x, r0z, r1x, r1z, x1, z1, tx, tz);
+                dbl(r0x, r0z, r0x, r0z);
+                r1x=tx;
+                r1z=tz;
+            }
+        }
+        x1=r0x;
+        z1=r0z;
+    };
+
+    for(curve=0;curve<curves;curve++){
+        // Suyama: u=sigma^2-5, v=4*sigma, x=u^3, z=v^3, a24=(v-u)^3(3u+v)/(16u^3v)
+        u=(mpz_class)(seed+curve)*(seed+curve)-5;
+        v=4*(mpz_class)(seed+curve);
+        x=u*u*u%n;
+        z=v*v*v%n;
+        t=16*x*v%n;
+        if(mpz_invert(inv.get_mpz_t(), t.get_mpz_t(), n.get_mpz_t())==0){
+            f=gcd(t, n);
+            if(f!=1 && f!=n)
+                return true;
+            continue;
+        }
+        t=v-u;
+        a24=t*t%n*t%n*(3*u+v)%n*inv%n;
+
+        // stage 1
+        for(k=0;k<primes.size() && primes[k]<=b1;k++){
+            for(q=primes[k];q*primes[k]<=b1;q*=primes[k]);
+            ladder(x, z, q);
+        }
+        f=gcd(z, n);
+        if(f!=1 && f!=n)
+            return true;
+        if(f==n)
+            continue;
+
+        // stage 2: baby steps j*P for odd j<d/2 prime to d=2*3*5*7, giant
+        // steps i*d*P
+        ox[1]=x;
+        oz[1]=z;
+        dbl(x, z, sx, sz);
+        add(x, z, sx, sz, x, z, ox[3], oz[3]);
+        for(j=5;j<d/2;j+=2)
+            add(ox[j-2], oz[j-2], sx, sz, ox[j-4], oz[j-4], ox[j], oz[j]);
+        bx.clear();
+        bz.clear();
+        for(j=1;j<d/2;j+=2){
+            if(j%3!=0 && j%5!=0 && j%7!=0){
+                bx.push_back(ox[j]);
+                bz.push_back(oz[j]);
+            }
+        }
+        i=(b1/d>2) ? b1/d : 2;
+        sx=x;
+        sz=z;
+        ladder(sx, sz, d);
+        gx=x;
+        gz=z;
+        ladder(gx, gz, i*d);
+        hx=x;
+        hz=z;
+        ladder(hx, hz, (i-1)*d);
+        acc=1;
+        for(;i*d<=b2+d;i++){
+            for(k=0;k<bx.size();k++){
+                acc*=gx*bz[k]-bx[k]*gz;
+                acc%=n;
+            }
+            add(gx, gz, sx, sz, hx, hz, nx, nz);
+            hx=gx;
+            hz=gz;
+            gx=nx;
+            gz=nz;
+        }
+        f=gcd(acc, n);
+        if(f!=1 && f!=n)
+            return true;
+    }
+
+    return false;
+}
+
+// Routine to add the prime factors of n, with repeats, to f
+// Trial division takes out the factors below 65536, a short run of Pollard's
+// rho the ones of up to about ten digits and ECM, at growing bounds, what is
+// left.  Returns false if a composite part could not be split.
+bool factorize(mpz_class n, vector<mpz_class> &f){
+    const vector<uint32_t> &primes=smallprimes();
+    vector<mpz_class> todo;
+    mpz_class m, d;
+    size_t k;
+
+    for(k=0;k<primes.size() && n>1;k++){
+        if(n<(mpz_class)primes[k]*primes[k]){
+            f.push_back(n);
+            return true;
+        }
+        while(mpz_divisible_ui_p(n.get_mpz_t(), primes[k])){
+            f.push_back(primes[k]);
+            mpz_divexact_ui(n.get_mpz_t(), n.get_mpz_t(), primes[k]);
+        }
+    }
+    if(n>1)
+        todo.push_back(n);
+    while(!todo.empty()){
+        m=todo.back();
+        todo.pop_back();
+        if(mpz_probab_prime_p(m.get_mpz_t(), 25)>0){
+            f.push_back(m);
+            continue;
+        }
+        if(rhofactor(m, d, 1<<16)==false && ecmfactor(m, d, 2000, 25, 6)==false && ecmfactor(m, d, 11000, 90, 31)==false && ecmfactor(m, d, 50000, 200, 121)==false)
+            return false;
+        todo.push_back(d);
+        todo.push_back(m/d);
+    }
+
+    return true;
+}
+
+// Routine to find the sum of the proper divisors of n, the next aliquot term
+// Returns false if n could not be factored.
+bool aliquotsum(const mpz_class &n, mpz_class &s){
+    vector<mpz_class> f;
+    mpz_class sigma=1, term, power;
+    size_t k;
+
+    if(n<2){
+        s=0;
+        return true;
+    }
+    if(factorize(n, f)==false)
+        return false;
+    sort(f.begin(), f.end());
+    for(k=0;k<f.size();){
+        term=1;
+        power=1;
+        do{
+            power*=f[k];
+            term+=power;
+            k++;
+        }while(k<f.size() && f[k]==f[k-1]);
+        sigma*=term;
+    }
+    s=sigma-n;
+
+    return true;
+}
+
+// Routine to add the cycle through value, with len members, to the cycle catalog
+// The members are found by taking aliquot sums from value, so no network is
+// needed.  Nothing is added if value is already catalogued, and a member that
+// cannot be factored or is already catalogued cuts the cycle short.  A
+// catalog still in a mapped snapshot is copied out first.
+void addcycle(struct seqtable &st, string value, int len){
+    struct cyclecatalog &cc=st.cycles;
+    vector<string> members;
+    const char *before;
+    mpz_class x;
+    uint32_t first, m;
+    int k;
+
+    if(cyclefind(st, value)>=0)
+        return;
+    if(x.set_str(value, 10)!=0)
+        len=1;
+    for(k=0;k<len;k++){
+        if(k>0){
+            if(aliquotsum(x, x)==false)
+                break;
+            value=x.get_str();
+            if(cyclefind(st, value)>=0 || find(members.begin(), members.end(), value)!=members.end())
+                break;
+        }
+        members.push_back(value);
+    }
+    if(cc.ownstart.empty()){
+        cc.ownstart.assign(cc.start, cc.start+cc.count+1);
+        cc.ownoff.assign(cc.off, cc.off+cc.members+1);
+        cc.ownchars.assign(cc.chars, cc.off[cc.members]);
+    }
+    before=cc.ownchars.data();
+    first=cc.members;
+    for(k=0;k<(int)members.size();k++){
+        cc.ownchars.append(members[k]);
+        cc.ownoff.push_back(cc.ownchars.size());
+    }
+    cc.ownstart.push_back(cc.ownoff.size()-1);
+    cc.count=cc.ownstart.size()-1;
+    cc.members=cc.ownoff.size()-1;
+    cc.start=cc.ownstart.data();
+    cc.off=cc.ownoff.data();
+    cc.chars=cc.ownchars.data();
+    // the lookup table holds views into chars, so it only survives if chars stayed put
+    if(cc.chars!=before)
+        cc.ids.clear();
+    else
+        for(m=first;m<cc.members;m++)
+            cc.ids.emplace(cyclevalue(st, m), m);
+
+    return;
+}
+
+// Routine to build the cycle catalog of a table
+// Every cycle entry point (elD of a sequence with elB<0) that is not yet in
+// the catalog starts a new cycle of -elB members.
+void buildcycles(struct seqtable &st){
+    struct cyclecatalog &cc=st.cycles;
+    vector<int> len(st.dict.count, 0);
+    uint32_t id;
+    int i;
+
+    for(i=2;i<st.seqscount;i++)
+        if(st.elB[i]<0)
+            len[st.elD[i]]=-st.elB[i];
+    cc=cyclecatalog();
+    cc.ownstart.assign(1, 0);
+    cc.ownoff.assign(1, 0);
+    cc.start=cc.ownstart.data();
+    cc.off=cc.ownoff.data();
+    cc.chars=cc.ownchars.data();
+    for(id=0;id<st.dict.count;id++)
+        if(len[id]>0)
+            addcycle(st, string(dictvalue(st, id)), len[id]);
+
+    return;
+}
+
+// Routine to list the members of the cycle that value belongs to
+// The list starts at value and follows the cycle round; it is empty if value
+// is in no cycle of the catalog.
+vector<string_view> cyclemembers(struct seqtable &st, string_view value){
+    vector<string_view> members;
+    uint32_t first, len, m, k;
+    int64_t at;
+
+    at=cyclefind(st, value);
+    if(at<0)
+        return members;
+    k=cycleof(st, at);
+    first=st.cycles.start[k];
+    len=st.cycles.start[k+1]-first;
+    for(m=0;m<len;m++)
+        members.push_back(cyclevalue(st, first+(at-first+m)%len));
+
+    return members;
+}
+
+// Routine to list the sequences that end in the cycle value belongs to, in
+// sequence order
+// Every sequence whose elD is one of the members of the cycle is included.
+vector<uint32_t> cyclesequences(struct seqtable &st, string_view value){
+    vector<uint32_t> seqlist;
+    vector<string_view> members;
+    const uint32_t *seqs;
+    size_t k, nseqs;
+    int64_t id;
+
+    members=cyclemembers(st, value);
+    for(k=0;k<members.size();k++){
+        id=dictfind(st, members[k]);
+        if(id>=0){
+            nseqs=elDseqs(st, id, seqs);
+            seqlist.insert(seqlist.end(), seqs, seqs+nseqs);
+        }
+    }
+    sort(seqlist.begin(), seqlist.end());
+
+    return seqlist;
+}
+
+// Routines to map a column value to an unsigned key with the same order
+static inline uint64_t sortkey(uint32_t v){
+    return v;
+}
+static inline uint64_t sortkey(double v){
+    uint64_t u;
+
+    memcpy(&u, &v, 8);
+    return (u>>63) ? ~u : u|((uint64_t)1<<63);
+}
+
+// Routine to sort the sequences of one column by value into rows
+// Columns of one or two bytes are placed with a counting sort over mn..mx.
+// Wider columns get a radix sort, 8 bits of sortkey() at a time, that passes
+// over any 8 bits every value shares.  Both sorts are stable, so sequences of
+// equal value stay in increasing order.  Sequences with NaN values are put in
+// nans instead.
+template<typename T>
+void sortcolumn(const T *col, int seqscount, double mn, double mx, vector<uint32_t> &rows, vector<uint32_t> &nans){
+    vector<uint32_t> start, trows;
+    vector<uint64_t> keys, tkeys;
+    uint32_t *cnt, sum, v;
+    int64_t lo;
+    size_t i, n;
+    int d;
+
+    rows.clear();
+    nans.clear();
+    if(sizeof(T)<=2){
+        if(mn>mx)
+            return;
+        lo=(int64_t)mn;
+        start.assign((int64_t)mx-lo+2, 0);
+        for(d=2;d<seqscount;d++)
+            start[(int64_t)col[d]-lo+1]++;
+        for(i=1;i<start.size();i++)
+            start[i]+=start[i-1];
+        rows.resize(seqscount-2);
+        for(d=2;d<seqscount;d++)
+            rows[start[(int64_t)col[d]-lo]++]=d;
+        return;
+    }
+    rows.reserve(seqscount-2);
+    keys.reserve(seqscount-2);
+    for(d=2;d<seqscount;d++){
+        if(col[d]==col[d]){
+            rows.push_back(d);
+            keys.push_back((sizeof(T)==8) ? sortkey((double)col[d]) : sortkey((uint32_t)col[d]));
+        }
+        else
+            nans.push_back(d);
+    }
+    n=rows.size();
+    if(n==0)
+        return;
+    start.assign(8*256, 0);
+    for(i=0;i<n;i++)
+        for(d=0;d<8;d++)
+            start[d*256+((keys[i]>>(8*d))&0xff)]++;
+    trows.resize(n);
+    tkeys.resize(n);
+    for(d=0;d<8;d++){
+        cnt=&start[d*256];
+        if(cnt[(keys[0]>>(8*d))&0xff]==n)
+            continue;
+        for(sum=0, i=0;i<256;i++){
+            v=cnt[i];
+            cnt[i]=sum;
+            sum+=v;
+        }
+        for(i=0;i<n;i++){
+            v=cnt[(keys[i]>>(8*d))&0xff]++;
+            tkeys[v]=keys[i];
+            trows[v]=rows[i];
+        }
+        keys.swap(tkeys);
+        rows.swap(trows);
+    }
+
+    return;
+}
+
+// Routine to build the sorted index of numeric column c, if not built yet
+void buildcolindex(struct seqtable &st, int c){
+    struct colindex &ci=st.sorted[c];
+    uint64_t start;
+
+    if(ci.built==true)
+        return;
+    start=phasestart();
+    switch(colwidth[c]){
+        case 1:
+            if(c==colB)
+                sortcolumn(st.elB, st.seqscount, st.colmin[c], st.colmax[c], ci.rows, ci.nans);
+            else
+                sortcolumn((const uint8_t *)colarray(st, c), st.seqscount, st.colmin[c], st.colmax[c], ci.rows, ci.nans);
+            break;
+        case 2:
+            sortcolumn((const uint16_t *)colarray(st, c), st.seqscount, st.colmin[c], st.colmax[c], ci.rows, ci.nans);
+            break;
+        case 4:
+            sortcolumn((const uint32_t *)colarray(st, c), st.seqscount, st.colmin[c], st.colmax[c], ci.rows, ci.nans);
+            break;
+        case 8:
+            sortcolumn((const double *)colarray(st, c), st.seqscount, st.colmin[c], st.colmax[c], ci.rows, ci.nans);
+            break;
+    }
+    ci.built=true;
+    phaseend(phaseindex, start);
+
+    return;
+}
+
+// Routine to find the run of a sorted index whose values lie in lo..hi
+// The sequences are rows[from] up to rows[to].
+template<typename T>
+void sortedrun(const T *col, const vector<uint32_t> &rows, double lo, double hi, size_t &from, size_t &to){
+    from=lower_bound(rows.begin(), rows.end(), lo, [col](uint32_t r, double v){ return col[r]<v; })-rows.begin();
+    to=upper_bound(rows.begin()+from, rows.end(), hi, [col](double v, uint32_t r){ return v<col[r]; })-rows.begin();
+    if(to<from)
+        to=from;
+
+    return;
+}
+
+// Routine to find the sequences of a built column index with values in lo..hi
+// The sequences are st.sorted[c].rows[from] up to st.sorted[c].rows[to].
+void indexrange(struct seqtable &st, int c, double lo, double hi, size_t &from, size_t &to){
+    const vector<uint32_t> &rows=st.sorted[c].rows;
+
+    switch(colwidth[c]){
+        case 1:
+            if(c==colB)
+                sortedrun(st.elB, rows, lo, hi, from, to);
+            else
+                sortedrun((const uint8_t *)colarray(st, c), rows, lo, hi, from, to);
+            break;
+        case 2:
+            sortedrun((const uint16_t *)colarray(st, c), rows, lo, hi, from, to);
+            break;
+        case 4:
+            sortedrun((const uint32_t *)colarray(st, c), rows, lo, hi, from, to);
+            break;
+        case 8:
+            sortedrun((const double *)colarray(st, c), rows, lo, hi, from, to);
+            break;
+    }
+
+    return;
+}
+
+// Routine to store field c of a parsed line in col[i], clamped to fit
+// Bit c of clamped is set if the value had to be changed.
+template<typename T>
+static inline void putfield(T *col, int i, int c, int v, uint32_t &clamped){
+    col[i]=narrow<T>(v);
+    if(col[i]!=v)
+        clamped|=(uint32_t)1<<c;
+
+    return;
+}
+
+// Routine to count the clamped fields of sequence i into cl
+void noteclamps(struct clampcounts &cl, uint32_t clamped, int i){
+    int c;
+
+    for(c=0;c<ncols;c++){
+        if((clamped>>c&1)==0)
+            continue;
+        if(cl.count[c]++==0 || (uint32_t)i<cl.first[c])
+            cl.first[c]=i;
+    }
+
+    return;
+}
+
+// Routine to add the clamp counts of from to those of to
+void addclamps(struct clampcounts &to, const struct clampcounts &from){
+    int c;
+
+    for(c=0;c<ncols;c++){
+        if(from.count[c]==0)
+            continue;
+        if(to.count[c]==0 || from.first[c]<to.first[c])
+            to.first[c]=from.first[c];
+        to.count[c]+=from.count[c];
+    }
+
+    return;
+}
+
+// Routine to write a warning for each column with clamped values
+void reportclamps(const struct seqtable &st, ostream &out){
+    int c;
+
+    for(c=0;c<ncols;c++){
+        if(st.clamps.count[c]==0)
+            continue;
+        out << "Warning: " << st.clamps.count[c] << " value" << ((st.clamps.count[c]==1) ? "" : "s") << " of el" << (char)('B'+c) << " did not fit and ";
+        out << ((st.clamps.count[c]==1) ? "was" : "were") << " stored clamped to ";
+        if(c==colB)
+            out << "-128..127";
+        else if(c==colE)
+            out << "0..4294967295";
+        else if(c==colF)
+            out << "0..255";
+        else
+            out << "0..65535";
+        out << ", the first in sequence " << st.clamps.first[c] << endl;
+    }
+
+    return;
+}
+
+// Routine to store a parsed line as row i of a table
+// elD is interned separately by the loader.  Returns a mask with bit c set
+// for each column c whose value had to be clamped to fit.
+uint32_t putrow(struct seqtable &st, int i, const struct seqrow &r){
+    uint32_t clamped=0;
+    int c;
+
+    putfield(st.elB, i, colB, r.ints[colB], clamped);
+    putfield(st.elC, i, colC, r.ints[colC], clamped);
+    st.elE[i]=(r.ints[colE]<0) ? 0 : r.ints[colE];
+    if(r.ints[colE]<0)
+        clamped|=(uint32_t)1<<colE;
+    putfield(st.elF, i, colF, r.ints[colF], clamped);
+    for(c=colG;c<=colN;c++)
+        putfield((uint16_t *)colarray(st, c), i, c, r.ints[c], clamped);
+    st.elO[i]=r.dbls[colO-colO];
+    st.elP[i]=r.dbls[colP-colO];
+    st.elQ[i]=r.dbls[colQ-colO];
+    st.elR[i]=r.dbls[colR-colO];
+    st.elS[i]=r.dbls[colS-colO];
+    st.elT[i]=r.dbls[colT-colO];
+
+    return clamped;
+}
+
+// Routine to read one numeric field at the cursor and step past its comma
+// A field that is empty or missing leaves v unchanged.
+template<typename T>
+static inline const char *readfield(const char *p, const char *eol, T &v){
+    const char *comma;
+
+    while(p<eol && (*p==' ' || *p=='+'))
+        p++;
+    from_chars(p, eol, v);
+    comma=(const char *)memchr(p, ',', eol-p);
+    if(comma==NULL)
+        return eol;
+    return comma+1;
+}
+
+// Routine to parse one line of regina_file in place
+// Returns the number of fields found on the line.  Fields missing from a
+// short line are left at zero.
+int parseline(const char *p, const char *eol, struct seqrow &r){
+    const char *comma;
+    int c;
+
+    memset(&r, 0, sizeof(r));
+    // elA not used
+    comma=(const char *)memchr(p, ',', eol-p);
+    if(comma==NULL)
+        return 0;
+    p=comma+1;
+    // Assign elB through elT, stopping at the end of a short line
+    for(c=0;c<ncols && p<eol;c++){
+        if(c==colD){
+            comma=(const char *)memchr(p, ',', eol-p);
+            if(comma==NULL)
+                comma=eol;
+            r.elD=p;
+            r.elDlen=comma-p;
+            p=comma+1;
+        }
+        else if(c<colO)
+            p=readfield(p, eol, r.ints[c]);
+        else
+            p=readfield(p, eol, r.dbls[c-colO]);
+    }
+
+    return c+1;
+}
+
+// Routine to count the lines in a block of regina_file
+int countlines(const char *p, const char *end){
+    int lines=0;
+
+    while(p<end){
+        p=(const char *)memchr(p, '\n', end-p);
+        lines++;
+        if(p==NULL)
+            break;
+        p++;
+    }
+
+    return lines;
+}
+
+// structure for the elD values met while parsing one block of regina_file
+// Rows parsed from the block temporarily hold ids into this local list until
+// the loader merges every block's values into the table dictionary.
+struct chunkdict{
+    unordered_map<string_view, uint32_t> ids;  // value to local id
+    vector<string_view> values;  // values in order of first appearance
+};
+
+// Routine to parse a newline-aligned block of regina_file whose first line is
+// sequence row into a table.  Lines past the end of the table are skipped.
+void parsechunk(const char *p, const char *end, int row, struct seqtable &st, struct endcounts &ec, struct clampcounts &cl, struct chunkdict &cd){
+    struct seqrow r;
+    const char *eol;
+    uint32_t clamped;
+
+    while(p<end && row<st.seqscount){
+        eol=(const char *)memchr(p, '\n', end-p);
+        if(eol==NULL)
+            eol=end;
+        if(parseline(p, eol, r)>1){
+            if(r.ints[colB]>0)
+                ec.pcount++;
+            if(r.ints[colB]==0)
+                ec.ocount++;
+            if(r.ints[colB]<0)
+                ec.ccount++;
+        }
+        clamped=putrow(st, row, r);
+        if(clamped!=0)
+            noteclamps(cl, clamped, row);
+        auto ins=cd.ids.emplace(string_view(r.elD, r.elDlen), (uint32_t)cd.values.size());
+        if(ins.second==true)
+            cd.values.push_back(ins.first->first);
+        st.elD[row]=ins.first->second;
+        row++;
+        p=eol+1;
+    }
+
+    return;
+}
+
+// Routine to load regina_file into a new table
+// The file is memory-mapped and walked with a single forward cursor.  Sequence
+// numbers follow line order starting at 2, as with the original getline loop.
+// The lines are counted first to size the table.  With more than one thread
+// the file is cut into newline-aligned chunks whose lines are counted in
+// parallel, so each chunk knows its starting sequence and all chunks can then
+// be parsed in parallel straight into their rows.
+bool loadregina(string infile, struct seqtable &st, int nthreads){
+    struct filemap fm;
+    struct endcounts ec={0, 0, 0};
+    struct clampcounts cl={};
+    vector<struct endcounts> chunkec;
+    vector<struct clampcounts> chunkcl;
+    vector<struct chunkdict> chunkd;
+    vector<vector<uint32_t>> remap;
+    unordered_map<string_view, uint32_t> ids;
+    vector<const char *> cut;
+    vector<int> rows;
+    const char *end, *p;
+    int i, nchunks;
+    size_t k;
+
+    if(openmap(infile, fm)==false)
+        return false;
+    perf.bytesread+=fm.size;
+    end=fm.data+fm.size;
+    nchunks=(nthreads<2) ? 1 : nthreads*8;
+    cut.push_back(fm.data);
+    for(i=1;i<nchunks;i++){
+        p=fm.data+fm.size/nchunks*i;
+        if(p<cut.back())
+            p=cut.back();
+        p=(const char *)memchr(p, '\n', end-p);
+        cut.push_back(p==NULL ? end : p+1);
+    }
+    cut.push_back(end);
+    rows.assign(nchunks+1, 0);
+    parallelfor(nthreads, nchunks, [&](int t, int){
+        rows[t+1]=countlines(cut[t], cut[t+1]);
+    });
+    rows[0]=2;
+    for(i=0;i<nchunks;i++)
+        rows[i+1]+=rows[i];
+    if(newtable(st, rows[nchunks])==false){
+        closemap(fm);
+        return false;
+    }
+    chunkec.assign(nchunks, ec);
+    chunkcl.assign(nchunks, cl);
+    chunkd.resize(nchunks);
+    parallelfor(nthreads, nchunks, [&](int t, int){
+        parsechunk(cut[t], cut[t+1], rows[t], st, chunkec[t], chunkcl[t], chunkd[t]);
+    });
+    for(i=0;i<nchunks;i++){
+        ec.pcount+=chunkec[i].pcount;
+        ec.ccount+=chunkec[i].ccount;
+        ec.ocount+=chunkec[i].ocount;
+        addclamps(cl, chunkcl[i]);
+    }
+    st.ends=ec;
+    st.clamps=cl;
+
+    // Merge the block dictionaries in file order, so ids follow the first
+    // appearance of each value.  Id 0 is the empty value of unused rows.
+    ids.emplace(string_view(), 0);
+    st.dict.ownoff.assign(2, 0);
+    remap.resize(nchunks);
+    for(i=0;i<nchunks;i++){
+        for(k=0;k<chunkd[i].values.size();k++){
+            auto ins=ids.emplace(chunkd[i].values[k], (uint32_t)ids.size());
+            if(ins.second==true){
+                st.dict.ownchars.append(chunkd[i].values[k]);
+                st.dict.ownoff.push_back(st.dict.ownchars.size());
+            }
+            remap[i].push_back(ins.first->second);
+        }
+    }
+    st.dict.count=ids.size();
+    st.dict.chars=st.dict.ownchars.data();
+    st.dict.off=st.dict.ownoff.data();
+    parallelfor(nthreads, nchunks, [&](int t, int){
+        int j;
+
+        for(j=rows[t];j<rows[t+1];j++)
+            st.elD[j]=remap[t][st.elD[j]];
+    });
+    closemap(fm);
+    columnstats(st, nthreads);
+    buildcycles(st);
+
+    return true;
+}
+
+// structure for a bounded queue of data blocks passed between threads (the
+// stages of the archive loader, a resultwriter and its flusher)
+// Blocks the consumer is done with are kept as spares for the producer to
+// refill, so the stages reuse a fixed set of buffers.
+struct blockring{
+    mutex lock;  // guards everything below
+    condition_variable changed;  // signalled when blocks, spares or flags change
+    deque<vector<char>> blocks;  // filled blocks in stream order
+    vector<vector<char>> spares;  // emptied blocks ready for reuse
+    size_t limit=8;  // most filled blocks held at once
+    bool done=false;  // the producer has finished
+    bool failed=false;  // the producer stopped on an error
+    bool closed=false;  // the consumer has stopped, so the producer should too
+};
+
+// Routine to queue block b, waiting while the ring is full
+// b is swapped for a spare buffer, or left empty.  Returns false if the
+// consumer has stopped.
+bool ringput(struct blockring &r, vector<char> &b){
+    unique_lock<mutex> hold(r.lock);
+
+    r.changed.wait(hold, [&]{ return r.closed==true || r.blocks.size()<r.limit; });
+    if(r.closed==true)
+        return false;
+    r.blocks.push_back(move(b));
+    b=vector<char>();
+    if(!r.spares.empty()){
+        b=move(r.spares.back());
+        r.spares.pop_back();
+    }
+    r.changed.notify_all();
+
+    return true;
+}
+
+// Routine to take the next block into b, handing back the block b held
+// Returns false once the producer has finished and every block was taken.
+bool ringget(struct blockring &r, vector<char> &b){
+    unique_lock<mutex> hold(r.lock);
+
+    if(b.capacity()>0){
+        b.clear();
+        r.spares.push_back(move(b));
+    }
+    b=vector<char>();
+    r.changed.wait(hold, [&]{ return r.done==true || !r.blocks.empty(); });
+    if(r.blocks.empty())
+        return false;
+    b=move(r.blocks.front());
+    r.blocks.pop_front();
+    r.changed.notify_all();
+
+    return true;
+}
+
+// Routine to mark the producer side of a ring finished
+void ringfinish(struct blockring &r, bool failed){
+    lock_guard<mutex> hold(r.lock);
+
+    r.done=true;
+    r.failed=(r.failed || failed);
+    r.changed.notify_all();
+
+    return;
+}
+
+// Routine to tell if the producer of a ring stopped on an error
+// Safe to call while the producer is still running.
+bool ringfailed(struct blockring &r){
+    lock_guard<mutex> hold(r.lock);
+
+    return r.failed;
+}
+
+// Routine to mark the consumer side of a ring stopped
+void ringclose(struct blockring &r){
+    lock_guard<mutex> hold(r.lock);
+
+    r.closed=true;
+    r.changed.notify_all();
+
+    return;
+}
+
+// layouts of the sequence numbers written by a resultwriter
+enum{fmtcolumns, fmtlines, fmtcsv, fmttsv, fmtbinary};
+const char *const fmtnames[]={"columns", "lines", "csv", "tsv", "binary"};
+
+// bytes a resultwriter collects before handing a block to its flusher
+const size_t writerblock=1<<20;
+
+// structure for a buffered, asynchronous list of sequence numbers
+// Numbers are formatted with to_chars into large blocks, and full blocks are
+// passed through a blockring to a flusher thread that writes them out, so
+// formatting carries on while the terminal or disk catches up.  A writer with
+// fd<0 is not open and ignores anything written to it.
+struct resultwriter{
+    int fd=-1;  // destination
+    bool ownfd=false;  // fd was opened by openwriterfile() and is closed with the writer
+    int format=fmtlines;  // fmtcolumns..fmtbinary
+    vector<char> block;  // block being filled
+    struct blockring ring;  // filled blocks waiting for the flusher
+    thread flusher;  // writes the blocks in order
+    uint64_t items=0;  // numbers written to the current list
+    bool failed=false;  // a write failed (read only after closewriter() joins)
+};
+
+// Routine to start a writer on an open file descriptor
+// Anything already buffered by cout is flushed first, so output stays in order
+// when fd is stdout.
+void openwriter(struct resultwriter &w, int fd, bool ownfd, int format){
+    cout.flush();
+    w.fd=fd;
+    w.ownfd=ownfd;
+    w.format=format;
+    w.items=0;
+    w.failed=false;
+    w.block.reserve(writerblock);
+    w.flusher=thread([&w](){
+        vector<char> b;
+        size_t done;
+        ssize_t n;
+
+        while(ringget(w.ring, b)==true){
+            for(done=0;done<b.size();done+=n){
+                n=write(w.fd, b.data()+done, b.size()-done);
+                if(n<0 && errno==EINTR)
+                    n=0;
+                else if(n<=0){
+                    w.failed=true;
+                    ringclose(w.ring);
+                    return;
+                }
+            }
+        }
+    });
+
+    return;
+}
+
+// Routine to start a writer on the file name, appended to or replaced
+bool openwriterfile(struct resultwriter &w, string name, bool append, int format){
+    int fd;
+
+    fd=open(name.c_str(), O_WRONLY|O_CREAT|((append==true) ? O_APPEND : O_TRUNC), 0644);
+    if(fd<0)
+        return false;
+    openwriter(w, fd, true, format);
+
+    return true;
+}
+
+// Routine to pass the block being filled to the flusher
+void writerhandoff(struct resultwriter &w){
+    if(w.block.empty())
+        return;
+    if(ringput(w.ring, w.block)==false)
+        w.block.clear();
+    if(w.block.capacity()<writerblock)
+        w.block.reserve(writerblock);
+
+    return;
+}
+
+// Routine to add raw bytes to a writer
+void writerbytes(struct resultwriter &w, const void *p, size_t n){
+    if(w.fd<0)
+        return;
+    w.block.insert(w.block.end(), (const char *)p, (const char *)p+n);
+    if(w.block.size()>=writerblock)
+        writerhandoff(w);
+
+    return;
+}
+
+// Routine to add text to a writer
+void writertext(struct resultwriter &w, string_view s){
+    writerbytes(w, s.data(), s.size());
+
+    return;
+}
+
+// Routine to add one sequence number to a writer in its format
+// columns pads each number to 10 characters as the screen listings always
+// have, lines puts one per line, csv and tsv separate them with a comma or a
+// tab (writerendlist() ends the line) and binary writes 4 byte little endian
+// values.
+void writerid(struct resultwriter &w, uint32_t id){
+    char *p, *start;
+    size_t at;
+
+    if(w.fd<0)
+        return;
+    if(w.format==fmtbinary){
+        writerbytes(w, &id, sizeof(id));
+        w.items++;
+        return;
+    }
+    at=w.block.size();
+    w.block.resize(at+16);
+    start=p=w.block.data()+at;
+    if((w.format==fmtcsv || w.format==fmttsv) && w.items>0)
+        *p++=(w.format==fmtcsv) ? ',' : '\t';
+    p=to_chars(p, start+16, id).ptr;
+    if(w.format==fmtcolumns){
+        while(p<start+10)
+            *p++=' ';
+        if(p>start+10)
+            p=start+10;
+    }
+    else if(w.format==fmtlines)
+        *p++='\n';
+    w.block.resize(p-w.block.data());
+    w.items++;
+    if(w.block.size()>=writerblock)
+        writerhandoff(w);
+
+    return;
+}
+
+// Routine to end a list of sequence numbers
+// Only csv and tsv lists need anything: the newline that ends their line.
+void writerendlist(struct resultwriter &w){
+    if(w.format==fmtcsv || w.format==fmttsv)
+        writertext(w, "\n");
+    w.items=0;
+
+    return;
+}
+
+// Routine to write out everything left in a writer and stop its flusher
+// Returns false if any write failed.
+bool closewriter(struct resultwriter &w){
+    bool ok;
+
+    if(w.fd<0)
+        return true;
+    writerhandoff(w);
+    ringfinish(w.ring, false);
+    w.flusher.join();
+    ok=!w.failed;
+    if(w.ownfd==true && close(w.fd)!=0)
+        ok=false;
+    w.fd=-1;
+    w.block=vector<char>();
+    w.ring.blocks.clear();
+    w.ring.spares.clear();
+    w.ring.done=false;
+    w.ring.failed=false;
+    w.ring.closed=false;
+
+    return ok;
+}
+
+// states of a tarreader
+enum{tarheader, tarbody, tarplain, tardone};
+
+// structure for picking regina_file out of a decompressed tar stream
+struct tarreader{
+    string header;  // bytes of a header still being gathered
+    uint64_t data=0;  // bytes of regina_file still to come
+    uint64_t skip=0;  // bytes of another member and padding still to skip
+    bool first=true;  // no header has been read yet
+    int state=tarheader;  // what the next bytes are
+};
+
+// Routine to read a numeric field of a tar header
+// Sizes past 8 GB use the base-256 form, flagged by the top bit.
+uint64_t tarnumber(const char *p, int len){
+    uint64_t v=0;
+    int i;
+
+    if((unsigned char)p[0]&0x80){
+        for(i=1;i<len;i++)
+            v=(v<<8)|(unsigned char)p[i];
+        return v;
+    }
+    for(i=0;i<len && (p[i]<'0' || p[i]>'7');i++);
+    for(;i<len && p[i]>='0' && p[i]<='7';i++)
+        v=v*8+(p[i]-'0');
+
+    return v;
+}
+
+// Routine to pass the text in block [p,end) of a decompressed archive to emit
+// A tar archive yields the contents of its first regular file.  Anything else
+// is taken to be regina_file itself.
+void untar(struct tarreader &tr, const char *p, const char *end, const function<void(const char *, const char *)> &emit){
+    uint64_t n, size;
+    char type;
+
+    while(p<end && tr.state!=tardone){
+        if(tr.state==tarplain){
+            emit(p, end);
+            return;
+        }
+        if(tr.skip>0){
+            n=((uint64_t)(end-p)<tr.skip) ? end-p : tr.skip;
+            p+=n;
+            tr.skip-=n;
+            continue;
+        }
+        if(tr.state==tarbody){
+            n=((uint64_t)(end-p)<tr.data) ? end-p : tr.data;
+            emit(p, p+n);
+            p+=n;
+            tr.data-=n;
+            if(tr.data==0)
+                tr.state=tardone;
+            continue;
+        }
+        n=((uint64_t)(end-p)<512-tr.header.size()) ? end-p : 512-tr.header.size();
+        tr.header.append(p, n);
+        p+=n;
+        if(tr.header.size()<512)
+            return;
+        if(tr.first==true && tr.header.compare(257, 5, "ustar")!=0){
+            tr.state=tarplain;
+            emit(tr.header.data(), tr.header.data()+512);
+            tr.header.clear();
+            continue;
+        }
+        tr.first=false;
+        if(tr.header.find_first_not_of('\0')==string::npos){
+            tr.state=tardone;
+            continue;
+        }
+        size=tarnumber(tr.header.data()+124, 12);
+        type=tr.header[156];
+        tr.header.clear();
+        if((type=='0' || type=='\0') && size>0){
+            tr.state=tarbody;
+            tr.data=size;
+        }
+        else
+            tr.skip=(size+511)/512*512;
+    }
+
+    return;
+}
+
+// Routine to tell whether a file is an lzma or xz archive
+// .xz files are known by their magic bytes; the older .lzma format has none,
+// so it is known by its name.
+bool isarchive(string infile){
+    const char magic[6]={'\xFD', '7', 'z', 'X', 'Z', '\0'};
+    char head[6];
+    ifstream in;
+
+    if(infile.size()>5 && infile.compare(infile.size()-5, 5, ".lzma")==0)
+        return true;
+    in.open(infile, ios::binary);
+    if(!in.read(head, sizeof(head)))
+        return false;
+
+    return memcmp(head, magic, sizeof(magic))==0;
+}
+
+// Routine to load regina_file straight from regina_file.tar.lzma (or .xz)
+// No unpacked copy is written.  A reader thread pulls the archive from disk
+// and a decoder thread runs liblzma on it, each passing blocks on through a
+// bounded ring, while the calling thread strips the tar framing and parses the
+// lines as they arrive, so disk, decompression and parsing all overlap.  The
+// number of lines is not known ahead, so the table doubles as it fills and is
+// trimmed at the end.
+bool loadarchive(string infile, struct seqtable &st, int nthreads){
+    struct blockring packed, text;
+    struct endcounts ec={0, 0, 0};
+    struct clampcounts cl={};
+    struct tarreader tr;
+    unordered_map<string, uint32_t> ids;
+    vector<uint64_t> dictoff;
+    vector<uint32_t> remap;
+    vector<char> block;
+    string carry, dictchars;
+    int fd, row=2;
+    bool ok=true;
+
+    fd=open(infile.c_str(), O_RDONLY);
+    if(fd<0)
+        return false;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if(newtable(st, zonerows)==false){
+        close(fd);
+        return false;
+    }
+    thread reader([&](){
+        vector<char> b;
+        ssize_t got=0;
+
+        for(;;){
+            b.resize(1<<20);
+            got=read(fd, b.data(), b.size());
+            if(got<=0)
+                break;
+            b.resize(got);
+            perf.bytesread+=got;
+            if(ringput(packed, b)==false)
+                break;
+        }
+        ringfinish(packed, got<0);
+    });
+    thread decoder([&](){
+        lzma_stream zs=LZMA_STREAM_INIT;
+        lzma_ret ret;
+        vector<char> in, out;
+        bool more=true;
+
+        ret=lzma_auto_decoder(&zs, UINT64_MAX, LZMA_CONCATENATED);
+        out.resize(4<<20);
+        zs.next_out=(uint8_t *)out.data();
+        zs.avail_out=out.size();
+        while(ret==LZMA_OK){
+            if(zs.avail_in==0 && more==true){
+                more=ringget(packed, in);
+                zs.next_in=(const uint8_t *)in.data();
+                zs.avail_in=in.size();
+            }
+            ret=lzma_code(&zs, (more==true) ? LZMA_RUN : LZMA_FINISH);
+            if(zs.avail_out==0 || ret!=LZMA_OK){
+                out.resize(out.size()-zs.avail_out);
+                if(!out.empty() && ringput(text, out)==false)
+                    break;
+                out.resize(4<<20);
+                zs.next_out=(uint8_t *)out.data();
+                zs.avail_out=out.size();
+            }
+        }
+        lzma_end(&zs);
+        ringclose(packed);
+        ringfinish(text, ret!=LZMA_STREAM_END || ringfailed(packed)==true);
+    });
+
+    // Parse the newline-aligned block [p,end) into the rows after those so far
+    // and merge its elD values into the table dictionary straight away, since
+    // the text they point into is about to be reused.
+    auto parseblock=[&](const char *p, const char *end){
+        struct chunkdict cd;
+        int j, n;
+        size_t k;
+
+        n=countlines(p, end);
+        if(row+n>st.seqscount && resizetable(st, max(st.seqscount*2, row+n))==false){
+            ok=false;
+            return;
+        }
+        parsechunk(p, end, row, st, ec, cl, cd);
+        remap.clear();
+        for(k=0;k<cd.values.size();k++){
+            auto ins=ids.emplace(string(cd.values[k]), (uint32_t)ids.size());
+            if(ins.second==true){
+                dictchars.append(cd.values[k]);
+                dictoff.push_back(dictchars.size());
+            }
+            remap.push_back(ins.first->second);
+        }
+        for(j=row;j<row+n;j++)
+            st.elD[j]=remap[st.elD[j]];
+        row+=n;
+    };
+    // Parse every complete line of [p,end), carrying a partial last line over
+    // to the next block.
+    auto emit=[&](const char *p, const char *end){
+        const char *nl;
+
+        if(!carry.empty()){
+            nl=(const char *)memchr(p, '\n', end-p);
+            if(nl==NULL){
+                carry.append(p, end);
+                return;
+            }
+            carry.append(p, nl+1);
+            parseblock(carry.data(), carry.data()+carry.size());
+            carry.clear();
+            p=nl+1;
+        }
+        nl=(const char *)memrchr(p, '\n', end-p);
+        if(nl==NULL){
+            carry.assign(p, end);
+            return;
+        }
+        parseblock(p, nl+1);
+        carry.assign(nl+1, end);
+    };
+
+    ids.emplace(string(), 0);
+    dictoff.assign(2, 0);
+    while(ok==true && ringget(text, block)==true)
+        untar(tr, block.data(), block.data()+block.size(), emit);
+    ringclose(text);
+    decoder.join();
+    reader.join();
+    close(fd);
+    if(tr.state==tarheader && tr.first==true)
+        emit(tr.header.data(), tr.header.data()+tr.header.size());
+    if(ok==true && !carry.empty())
+        parseblock(carry.data(), carry.data()+carry.size());
+    if(ok==false || text.failed==true || row==2 || resizetable(st, row)==false){
+        freetable(st);
+        return false;
+    }
+    st.ends=ec;
+    st.clamps=cl;
+    st.dict.ownchars=move(dictchars);
+    st.dict.ownoff=move(dictoff);
+    st.dict.count=ids.size();
+    st.dict.chars=st.dict.ownchars.data();
+    st.dict.off=st.dict.ownoff.data();
+    columnstats(st, nthreads);
+    buildcycles(st);
+
+    return true;
+}
+
+// Routine to hash a source file for snapshot validation
+// Hashing all of a multi-GB file would cost more than the snapshot saves, so
+// only the first and last megabyte and 256 evenly spaced 4 KB pages are used.
+uint64_t samplehash(const struct filemap &fm){
+    uint64_t h=14695981039346656037ULL;
+    size_t i, j, from, to;
+
+    auto mix=[&](size_t a, size_t b){
+        if(b>fm.size)
+            b=fm.size;
+        for(j=a;j<b;j++){
+            h^=(unsigned char)fm.data[j];
+            h*=1099511628211ULL;
+        }
+    };
+    mix(0, 1<<20);
+    if(fm.size>(1<<20)){
+        for(i=0;i<256;i++){
+            from=fm.size/256*i;
+            mix(from, from+4096);
+        }
+        to=fm.size;
+        from=(to>(1<<21)) ? to-(1<<20) : (1<<20);
+        mix(from, to);
+    }
+
+    return h;
+}
+
+// Routine to collect the size, modification time and sampled hash of a source file
+bool sourcekey(string infile, struct snapheader &sh){
+    struct filemap fm;
+    struct stat st;
+
+    if(stat(infile.c_str(), &st)!=0)
+        return false;
+    if(openmap(infile, fm)==false)
+        return false;
+    sh.srcsize=st.st_size;
+    sh.srcmtime=(int64_t)st.st_mtim.tv_sec*1000000000+st.st_mtim.tv_nsec;
+    sh.srchash=samplehash(fm);
+    closemap(fm);
+
+    return true;
+}
+
+// Routine to hash the first size bytes of the update file of infile
+// Returns false if the update file is missing or shorter than size.
+bool overlaykey(string infile, uint64_t size, uint64_t &hash){
+    struct filemap fm, part;
+
+    hash=0;
+    if(size==0)
+        return true;
+    if(openmap(infile+".update", fm)==false)
+        return false;
+    if(fm.size<size){
+        closemap(fm);
+        return false;
+    }
+    part=fm;
+    part.size=size;
+    hash=samplehash(part);
+    closemap(fm);
+
+    return true;
+}
+
+// Routine to tell if the sections named by a snapshot header lie inside it
+// Every array must start on a 64 byte boundary and end inside the file, the
+// string offsets of the dictionary and cycle catalog must not run backwards
+// or past their characters, and every elD must be a dictionary id, so a
+// snapshot that passes can be used without further checks.
+bool snapcheck(const struct snapheader &sh, const struct filemap &fm){
+    const uint64_t *off;
+    const uint32_t *start, *eld;
+    uint64_t rows=sh.seqscount, zones=(rows+zonerows-1)/zonerows, k;
+    uint32_t top;
+    int c;
+
+    // the section at off holding len bytes
+    auto fits=[&fm](uint64_t off, uint64_t len){
+        return off%64==0 && off<=fm.size && len<=fm.size-off;
+    };
+
+    if(rows<2 || rows>(uint64_t)numeric_limits<int>::max())
+        return false;
+    for(c=0;c<ncols;c++)
+        if(fits(sh.coloff[c], colwidth[c]*rows)==false)
+            return false;
+    if(fits(sh.zoneoff, (2*8+1)*zones*ncols)==false || fits(sh.histoff, 4*(uint64_t)ncols*histbins)==false)
+        return false;
+    if(fits(sh.dictoff, 8*((uint64_t)sh.dictcount+1))==false || sh.charoff!=sh.dictoff+8*((uint64_t)sh.dictcount+1))
+        return false;
+    off=(const uint64_t *)(fm.data+sh.dictoff);
+    for(k=0;k<sh.dictcount;k++)
+        if(off[k]>off[k+1])
+            return false;
+    if(off[0]!=0 || off[sh.dictcount]>fm.size-sh.charoff)
+        return false;
+    if(fits(sh.cstartoff, 4*((uint64_t)sh.cyclecount+1))==false || fits(sh.coffoff, 8*((uint64_t)sh.cyclemembers+1))==false)
+        return false;
+    start=(const uint32_t *)(fm.data+sh.cstartoff);
+    for(k=0;k<sh.cyclecount;k++)
+        if(start[k]>start[k+1])
+            return false;
+    if(start[0]!=0 || start[sh.cyclecount]!=sh.cyclemembers)
+        return false;
+    if(sh.ccharoff!=sh.coffoff+8*((uint64_t)sh.cyclemembers+1))
+        return false;
+    off=(const uint64_t *)(fm.data+sh.coffoff);
+    for(k=0;k<sh.cyclemembers;k++)
+        if(off[k]>off[k+1])
+            return false;
+    if(off[0]!=0 || off[sh.cyclemembers]>fm.size-sh.ccharoff)
+        return false;
+    eld=(const uint32_t *)(fm.data+sh.coloff[colD]);
+    top=0;
+    for(k=2;k<rows;k++)
+        top=max(top, eld[k]);
+
+    return rows==2 || top<sh.dictcount;
+}
+
+// Routine to load a table from the snapshot of infile
+// The columns and dictionary are used in place from the mapped snapshot.  Returns
+// false if there is no snapshot, it does not match the source file or its
+// sections do not fit in it (see snapcheck()).
+bool loadsnapshot(string infile, struct seqtable &st){
+    struct filemap fm;
+    struct snapheader sh, key;
+    uint64_t hash;
+    int rows;
+
+    if(sourcekey(infile, key)==false)
+        return false;
+    if(openmap(infile+".snap", fm)==false)
+        return false;
+    if(fm.size<sizeof(sh)){
+        closemap(fm);
+        return false;
+    }
+    perf.bytesread+=fm.size;
+    memcpy(&sh, fm.data, sizeof(sh));
+    if(memcmp(sh.magic, "SEQSNAP", 8)!=0 || sh.version!=snapversion || sh.filesize!=fm.size || sh.srcsize!=key.srcsize || sh.srcmtime!=key.srcmtime || sh.srchash!=key.srchash || snapcheck(sh, fm)==false){
+        closemap(fm);
+        return false;
+    }
+    // the update rows folded in must still be the start of the update file
+    if(overlaykey(infile, sh.overlaysize, hash)==false || hash!=sh.overlayhash){
+        closemap(fm);
+        return false;
+    }
+    madvise((void *)fm.data, fm.size, MADV_WILLNEED);
+    rows=sh.seqscount;
+    st=seqtable();
+    st.snap=fm;
+    setcolumns(st, (char *)fm.data, sh.coloff);
+    st.seqscount=rows;
+    st.ends.pcount=sh.pcount;
+    st.ends.ccount=sh.ccount;
+    st.ends.ocount=sh.ocount;
+    st.clamps=sh.clamps;
+    memcpy(st.colmin, sh.colmin, sizeof(st.colmin));
+    memcpy(st.colmax, sh.colmax, sizeof(st.colmax));
+    st.zones.count=(rows+zonerows-1)/zonerows;
+    st.zones.min=(const double *)(fm.data+sh.zoneoff);
+    st.zones.max=st.zones.min+(size_t)st.zones.count*ncols;
+    st.zones.nan=(const uint8_t *)(st.zones.max+(size_t)st.zones.count*ncols);
+    st.hist.count=(const uint32_t *)(fm.data+sh.histoff);
+    memcpy(st.hist.lo, sh.histlo, sizeof(st.hist.lo));
+    memcpy(st.hist.hi, sh.histhi, sizeof(st.hist.hi));
+    st.dict.count=sh.dictcount;
+    st.dict.off=(const uint64_t *)(fm.data+sh.dictoff);
+    st.dict.chars=fm.data+sh.charoff;
+    st.cycles.count=sh.cyclecount;
+    st.cycles.members=sh.cyclemembers;
+    st.cycles.start=(const uint32_t *)(fm.data+sh.cstartoff);
+    st.cycles.off=(const uint64_t *)(fm.data+sh.coffoff);
+    st.cycles.chars=fm.data+sh.ccharoff;
+    st.overlaid=sh.overlaysize;
+    st.overlayhash=sh.overlayhash;
+
+    return true;
+}
+
+// Routine to add a value to the elD dictionary of a table and return its id
+// A dictionary still in a mapped snapshot is copied out first.
+uint32_t dictadd(struct seqtable &st, string_view value){
+    struct eldict &d=st.dict;
+    const char *before;
+    uint32_t id;
+
+    if(d.ownoff.empty()){
+        d.ownoff.assign(d.off, d.off+d.count+1);
+        d.ownchars.assign(d.chars, d.off[d.count]);
+    }
+    before=d.ownchars.data();
+    d.ownchars.append(value);
+    d.ownoff.push_back(d.ownchars.size());
+    id=d.count++;
+    d.chars=d.ownchars.data();
+    d.off=d.ownoff.data();
+    // the lookup table holds views into chars, so it only survives if chars stayed put
+    if(d.chars!=before)
+        d.ids.clear();
+    else if(d.ids.size()>0)
+        d.ids.emplace(dictvalue(st, id), id);
+
+    return id;
+}
+
+// Routine to apply the update file <filename>.update to a table
+// The update file is an append-only list of regina_file lines, normally
+// added in sorted batches by createupdate(), and lines starting with # are
+// comments.  Only the bytes past st.overlaid are read; the last line for each
+// sequence wins and replaces its row in place.  The zone maps, histograms,
+// column ranges, ending counts, dictionary and cycle catalog are adjusted
+// for each replaced row rather than rebuilt, so the cost follows the number
+// of changed rows.  The histogram edges are kept in st.hist and do not follow
+// the widened column ranges, so values outside the old range count in the end
+// bins.  Values that do not fit their column are counted in st.clamps.
+// Returns the number of rows replaced.
+int applyoverlay(string infile, struct seqtable &st){
+    struct filemap fm;
+    struct seqrow r;
+    vector<pair<int, const char *>> lines;
+    double v;
+    const char *p, *eol, *end;
+    int64_t id;
+    size_t k;
+    uint32_t clamped;
+    int c, i, n=0, z;
+
+    if(openmap(infile+".update", fm)==false)
+        return 0;
+    if(fm.size<=st.overlaid){
+        closemap(fm);
+        return 0;
+    }
+    perf.bytesread+=fm.size-st.overlaid;
+    end=fm.data+fm.size;
+    for(p=fm.data+st.overlaid;p<end;p=eol+1){
+        eol=(const char *)memchr(p, '\n', end-p);
+        if(eol==NULL)
+            eol=end;
+        if(from_chars(p, eol, i).ptr!=p && i>=2 && i<st.seqscount)
+            lines.emplace_back(i, p);
+    }
+    stable_sort(lines.begin(), lines.end(), [](const pair<int, const char *> &a, const pair<int, const char *> &b){ return a.first<b.first; });
+
+    // the columns of a mapped snapshot are private pages, so writing copies
+    // only the pages that change
+    if(st.snap.mapped==true)
+        mprotect((void *)st.snap.data, st.snap.size, PROT_READ|PROT_WRITE);
+    if(st.zones.ownmin.empty()){
+        st.zones.ownmin.assign(st.zones.min, st.zones.min+(size_t)st.zones.count*ncols);
+        st.zones.ownmax.assign(st.zones.max, st.zones.max+(size_t)st.zones.count*ncols);
+        st.zones.ownnan.assign(st.zones.nan, st.zones.nan+(size_t)st.zones.count*ncols);
+        st.zones.min=st.zones.ownmin.data();
+        st.zones.max=st.zones.ownmax.data();
+        st.zones.nan=st.zones.ownnan.data();
+    }
+    if(st.hist.own.empty()){
+        st.hist.own.assign(st.hist.count, st.hist.count+(size_t)ncols*histbins);
+        st.hist.count=st.hist.own.data();
+    }
+    // add d to the histogram bin of column c for sequence i
+    auto histadd=[&](int c, int i, int d){
+        double lo=st.hist.lo[c], hi=st.hist.hi[c], scale=(hi>lo) ? histbins/(hi-lo) : 0;
+        int j;
+
+        v=colvalue(st, c, i);
+        if(v!=v)
+            return;
+        j=(int)((v-lo)*scale);
+        j=(j<0) ? 0 : (j>=histbins) ? histbins-1 : j;
+        st.hist.own[c*histbins+j]+=d;
+    };
+
+    for(k=0;k<lines.size();k++){
+        if(k+1<lines.size() && lines[k+1].first==lines[k].first)
+            continue;
+        i=lines[k].first;
+        p=lines[k].second;
+        eol=(const char *)memchr(p, '\n', end-p);
+        if(eol==NULL)
+            eol=end;
+        if(parseline(p, eol, r)<=1)
+            continue;
+        for(c=0;c<ncols;c++)
+            if(c!=colD)
+                histadd(c, i, -1);
+        st.ends.pcount-=(st.elB[i]>0);
+        st.ends.ocount-=(st.elB[i]==0);
+        st.ends.ccount-=(st.elB[i]<0);
+        clamped=putrow(st, i, r);
+        if(clamped!=0)
+            noteclamps(st.clamps, clamped, i);
+        id=dictfind(st, string_view(r.elD, r.elDlen));
+        st.elD[i]=(id>=0) ? id : dictadd(st, string_view(r.elD, r.elDlen));
+        st.ends.pcount+=(st.elB[i]>0);
+        st.ends.ocount+=(st.elB[i]==0);
+        st.ends.ccount+=(st.elB[i]<0);
+        z=i/zonerows;
+        for(c=0;c<ncols;c++){
+            if(c==colD)
+                continue;
+            histadd(c, i, 1);
+            v=colvalue(st, c, i);
+            if(v!=v){
+                st.zones.ownnan[(size_t)z*ncols+c]=1;
+                continue;
+            }
+            st.zones.ownmin[(size_t)z*ncols+c]=min(st.zones.ownmin[(size_t)z*ncols+c], v);
+            st.zones.ownmax[(size_t)z*ncols+c]=max(st.zones.ownmax[(size_t)z*ncols+c], v);
+            st.colmin[c]=min(st.colmin[c], v);
+            st.colmax[c]=max(st.colmax[c], v);
+        }
+        if(st.elB[i]<0)
+            addcycle(st, string(r.elD, r.elDlen), -st.elB[i]);
+        n++;
+    }
+    if(n>0){
+        st.inv=elDindex();
+        for(c=0;c<ncols;c++)
+            st.sorted[c]=colindex();
+    }
+    st.overlaid=fm.size;
+    st.overlayhash=samplehash(fm);
+    closemap(fm);
+
+    return n;
+}
+
+// Routine to pad a file being written with zeros up to offset off
+bool padto(FILE *fp, uint64_t off){
+    while((uint64_t)ftell(fp)<off)
+        if(fputc(0, fp)==EOF)
+            return false;
+
+    return true;
+}
+
+// Routine to write a snapshot of a table next to infile
+// The snapshot is written to a temporary file <filename>.snap.XXXXXX made by
+// mkstemp() and renamed into place, so a reader never sees a partial file and
+// two processes saving at once do not write into the same file.  Failure to
+// write is not an error.
+void savesnapshot(string infile, struct seqtable &st){
+    struct snapheader sh;
+    string tmpname=infile+".snap.XXXXXX";
+    FILE *fp;
+    uint64_t off;
+    int c, fd;
+    bool ok;
+
+    memset(&sh, 0, sizeof(sh));
+    if(sourcekey(infile, sh)==false)
+        return;
+
+    memcpy(sh.magic, "SEQSNAP", 8);
+    sh.version=snapversion;
+    sh.seqscount=st.seqscount;
+    sh.pcount=st.ends.pcount;
+    sh.ccount=st.ends.ccount;
+    sh.ocount=st.ends.ocount;
+    sh.clamps=st.clamps;
+    sh.dictcount=st.dict.count;
+    sh.overlaysize=st.overlaid;
+    sh.overlayhash=st.overlayhash;
+    memcpy(sh.colmin, st.colmin, sizeof(sh.colmin));
+    memcpy(sh.colmax, st.colmax, sizeof(sh.colmax));
+    memcpy(sh.histlo, st.hist.lo, sizeof(sh.histlo));
+    memcpy(sh.histhi, st.hist.hi, sizeof(sh.histhi));
+    off=layoutcolumns(st.seqscount, sizeof(sh), sh.coloff);
+    off=(off+63)/64*64;
+    sh.zoneoff=off;
+    off+=(2*8+1)*(uint64_t)st.zones.count*ncols;
+    off=(off+63)/64*64;
+    sh.histoff=off;
+    off+=4*(uint64_t)ncols*histbins;
+    off=(off+63)/64*64;
+    sh.dictoff=off;
+    off+=8*((uint64_t)st.dict.count+1);
+    sh.charoff=off;
+    off+=st.dict.off[st.dict.count];
+    off=(off+63)/64*64;
+    sh.cyclecount=st.cycles.count;
+    sh.cyclemembers=st.cycles.members;
+    sh.cstartoff=off;
+    off+=4*((uint64_t)st.cycles.count+1);
+    off=(off+63)/64*64;
+    sh.coffoff=off;
+    off+=8*((uint64_t)st.cycles.members+1);
+    sh.ccharoff=off;
+    off+=st.cycles.off[st.cycles.members];
+    sh.filesize=off;
+
+    fd=mkstemp(&tmpname[0]);
+    if(fd<0)
+        return;
+    fp=fdopen(fd, "wb");
+    if(fp==NULL){
+        close(fd);
+        remove(tmpname.c_str());
+        return;
+    }
+    // mkstemp() makes the file readable by its owner only
+    ok=(fchmod(fd, 0644)==0);
+    if(ok==true)
+        ok=(fwrite(&sh, sizeof(sh), 1, fp)==1);
+    for(c=0;c<ncols && ok==true;c++){
+        ok=padto(fp, sh.coloff[c]);
+        if(ok==true)
+            ok=(fwrite(colarray(st, c), colwidth[c], st.seqscount, fp)==(size_t)st.seqscount);
+    }
+    if(ok==true)
+        ok=padto(fp, sh.zoneoff);
+    if(ok==true)
+        ok=(fwrite(st.zones.min, 8*ncols, st.zones.count, fp)==(size_t)st.zones.count);
+    if(ok==true)
+        ok=(fwrite(st.zones.max, 8*ncols, st.zones.count, fp)==(size_t)st.zones.count);
+    if(ok==true)
+        ok=(fwrite(st.zones.nan, ncols, st.zones.count, fp)==(size_t)st.zones.count);
+    if(ok==true)
+        ok=padto(fp, sh.histoff);
+    if(ok==true)
+        ok=(fwrite(st.hist.count, 4*histbins, ncols, fp)==ncols);
+    if(ok==true)
+        ok=padto(fp, sh.dictoff);
+    if(ok==true)
+        ok=(fwrite(st.dict.off, 8, st.dict.count+1, fp)==st.dict.count+1);
+    if(ok==true)
+        ok=(fwrite(st.dict.chars, 1, st.dict.off[st.dict.count], fp)==st.dict.off[st.dict.count]);
+    if(ok==true)
+        ok=padto(fp, sh.cstartoff);
+    if(ok==true)
+        ok=(fwrite(st.cycles.start, 4, st.cycles.count+1, fp)==st.cycles.count+1);
+    if(ok==true)
+        ok=padto(fp, sh.coffoff);
+    if(ok==true)
+        ok=(fwrite(st.cycles.off, 8, st.cycles.members+1, fp)==st.cycles.members+1);
+    if(ok==true)
+        ok=(fwrite(st.cycles.chars, 1, st.cycles.off[st.cycles.members], fp)==st.cycles.off[st.cycles.members]);
+    if(fclose(fp)!=0)
+        ok=false;
+    if(ok==true)
+        ok=(rename(tmpname.c_str(), (infile+".snap").c_str())==0);
+    if(ok==false)
+        remove(tmpname.c_str());
+
+    return;
+}
+
+// Routine to write the fields of sequence i as a regina_file line
+string rowtext(struct seqtable &st, int i){
+    char num[32];
+    string line=to_string(i);
+    int c;
+
+    for(c=0;c<ncols;c++){
+        line.push_back(',');
+        if(c==colD)
+            line.append(dictvalue(st, st.elD[i]));
+        else if(colwidth[c]==8)
+            line.append(num, to_chars(num, num+sizeof(num), colvalue(st, c, i)).ptr-num);
+        else
+            line.append(to_string((int64_t)colvalue(st, c, i)));
+    }
+
+    return line;
+}
+
+// states of an open-ended sequence under createupdate()
+enum{oeopen, oeprime, oecycle, oemerge};
+const char *const oenames[]={"open", "prime", "cycle", "merge"};
+
+// structure for the progress of one open-ended sequence under createupdate()
+struct oestate{
+    int seq;  // starting number
+    int index;  // index of term
+    string term;  // last term reached, in decimal
+    int digits;  // digits of the largest term reached
+    int state;  // oeopen until the sequence ends or merges
+    bool moved;  // changed since it was last written to the update file
+};
+
+// Routine to read the sequences of OE_3000000_C80.txt or its checkpoint
+// Each line holds a sequence, the index of its last known term and that term,
+// separated by spaces or commas, optionally followed by the state name, the
+// digits of the largest term and "moved" if the progress has not been written
+// to the update file yet (as the checkpoint writes them).  Lines that do
+// not start with a sequence number are skipped.  Returns false if the file
+// cannot be read.
+bool readoefile(string name, struct seqtable &st, vector<struct oestate> &oe){
+    ifstream in;
+    string line, word;
+    vector<string> words;
+    struct oestate s;
+    size_t k;
+
+    in.open(name);
+    if(!in.is_open())
+        return false;
+    while(getline(in, line)){
+        for(k=0;k<line.length();k++)
+            if(line[k]==',' || line[k]=='\t' || line[k]=='\r')
+                line[k]=' ';
+        istringstream split(line);
+        words.clear();
+        while(split >> word)
+            words.push_back(word);
+        if(words.size()<3 || !isdigit((unsigned char)words[0][0]) || words[2].find_first_not_of("0123456789")!=string::npos)
+            continue;
+        s.seq=atoi(words[0].c_str());
+        if(s.seq<2 || s.seq>=st.seqscount)
+            continue;
+        s.index=atoi(words[1].c_str());
+        s.term=words[2];
+        s.state=oeopen;
+        for(k=0;words.size()>3 && k<4;k++)
+            if(words[3]==oenames[k])
+                s.state=k;
+        s.digits=(words.size()>4) ? atoi(words[4].c_str()) : st.elF[s.seq];
+        if(s.digits<(int)s.term.length())
+            s.digits=s.term.length();
+        s.moved=(words.size()>5 && words[5]=="moved");
+        oe.push_back(s);
+    }
+
+    return true;
+}
+
+// Routine to write the progress of every sequence under createupdate()
+// The file is written beside name and renamed over it, so an interrupted
+// write never leaves a broken checkpoint.
+bool writeoefile(string name, const vector<struct oestate> &oe){
+    string tmpname=name+".tmp";
+    ofstream out;
+    size_t k;
+
+    out.open(tmpname);
+    if(!out.is_open())
+        return false;
+    for(k=0;k<oe.size();k++)
+        out << oe[k].seq << " " << oe[k].index << " " << oe[k].term << " " << oenames[oe[k].state] << " " << oe[k].digits << ((oe[k].moved==true) ? " moved\n" : "\n");
+    out.close();
+    if(out.fail() || rename(tmpname.c_str(), name.c_str())!=0){
+        remove(tmpname.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Routine to advance one open-ended sequence by aliquot sums
+// Stops when the sequence reaches a sequence of the table (and so shares its
+// ending), a known cycle or a prime, after steps terms, or at a term that
+// cannot be factored.  Reaching one of its own followers (an open sequence
+// that merges with s.seq) is not a merge.  Each new term is published to s
+// under lock.
+void advanceoe(struct seqtable &st, struct oestate &s, mutex &lock, int steps){
+    mpz_class x, next;
+    string term=s.term;
+    int k, index=s.index, state=oeopen;
+
+    x.set_str(term, 10);
+    for(k=0;k<=steps;k++){
+        if(x>=2 && x<st.seqscount && x!=s.seq && !(st.elB[x.get_si()]==0 && st.elD[x.get_si()]==st.elD[s.seq]))
+            state=oemerge;
+        else if(cyclefind(st, term)>=0)
+            state=oecycle;
+        else if(mpz_probab_prime_p(x.get_mpz_t(), 25)>0)
+            state=oeprime;
+        if(state!=oeopen || k==steps || aliquotsum(x, next)==false)
+            break;
+        x=next;
+        term=x.get_str();
+        index++;
+        lock_guard<mutex> hold(lock);
+        s.term=term;
+        s.index=index;
+        s.digits=max(s.digits, (int)term.length());
+        s.moved=true;
+    }
+    lock_guard<mutex> hold(lock);
+    if(state!=oeopen)
+        s.moved=true;
+    s.state=state;
+
+    return;
+}
+
+// Routine to split the regina_file line of sequence i into its fields
+vector<string> rowfields(struct seqtable &st, int i){
+    vector<string> fields;
+    string line=rowtext(st, i);
+    size_t from=0, comma;
+
+    do{
+        comma=line.find(',', from);
+        fields.push_back(line.substr(from, comma-from));
+        from=comma+1;
+    }while(comma!=string::npos);
+
+    return fields;
+}
+
+// Routine to join fields back into a regina_file line
+string joinfields(const vector<string> &fields){
+    string out;
+    size_t c;
+
+    for(c=0;c<fields.size();c++){
+        if(c>0)
+            out.push_back(',');
+        out.append(fields[c]);
+    }
+
+    return out;
+}
+
+// Routine to write the regina_file line of an updated sequence
+// Only the ending (elB, elD), the index (elC) and the digits of the largest
+// term (elF) can be brought up to date from the terms alone; the other fields
+// keep their old values.  A merged sequence takes the ending of the one it
+// reached.
+string oerow(struct seqtable &st, const struct oestate &s){
+    vector<string> fields=rowfields(st, s.seq);
+    int m;
+
+    fields[1+colC]=to_string(s.index);
+    fields[1+colF]=to_string(s.digits);
+    if(s.state==oeprime){
+        fields[1+colB]="1";
+        fields[1+colD]=s.term;
+    }
+    else if(s.state==oecycle){
+        fields[1+colB]=to_string(-(int)cyclemembers(st, s.term).size());
+        fields[1+colD]=s.term;
+    }
+    else if(s.state==oemerge){
+        m=atoi(s.term.c_str());
+        fields[1+colB]=to_string(st.elB[m]);
+        fields[1+colC]=to_string(s.index+st.elC[m]);
+        fields[1+colD]=dictvalue(st, st.elD[m]);
+        if(st.elF[m]>s.digits)
+            fields[1+colF]=to_string(st.elF[m]);
+    }
+
+    return joinfields(fields);
+}
+
+// Routine to write the regina_file line of sequence f, which merges with the
+// ended sequence s.seq
+// f takes the new ending of s.seq.  If s.seq merged into m, f now merges with
+// what m does, and the terms of s.seq up to m are added to its index.
+string followrow(struct seqtable &st, int f, const struct oestate &s){
+    vector<string> fields=rowfields(st, f);
+    int m;
+
+    if(s.state==oeprime){
+        fields[1+colB]="1";
+        fields[1+colD]=s.term;
+    }
+    else if(s.state==oecycle){
+        fields[1+colB]=to_string(-(int)cyclemembers(st, s.term).size());
+        fields[1+colD]=s.term;
+    }
+    else if(s.state==oemerge){
+        m=atoi(s.term.c_str());
+        fields[1+colB]=to_string(st.elB[m]);
+        fields[1+colC]=to_string(st.elC[f]+s.index);
+        fields[1+colD]=dictvalue(st, st.elD[m]);
+    }
+
+    return joinfields(fields);
+}
+
+// Routine to update all open-ended sequences
+// This function does not change the original regina_file, but provides an
+// additional file that updates the program data when it is run.  The
+// sequences listed in OE_3000000_C80.txt are advanced by repeated sums of
+// proper divisors (trial division, Pollard rho and ECM on GMP integers), one
+// sequence per task, with idle threads stealing the tasks of busy ones.
+// Progress is checkpointed to OE_3000000_C80.txt.ckpt every minute and at the
+// end, and a later run carries on from the checkpoint.  Every sequence that
+// moved since it was last written, in this run or an interrupted one, is
+// appended to <filename>.update as a regina_file line, together with the
+// sequences that merge with one that ended, in sequence order, and the update
+// file is applied to the table straight away.  The checkpoint then
+// keeps only the sequences still open, so finished ones are written once; it
+// is used until OE_3000000_C80.txt is replaced by a newer file.
+void createupdate(struct seqtable &st, string infile, int nthreads){
+    const string oename="OE_3000000_C80.txt", ckptname=oename+".ckpt";
+    struct stat ck, sb;
+    vector<struct oestate> oe;
+    vector<int> todo;
+    condition_variable wake;
+    mutex lock;
+    vector<pair<int, string>> rows;
+    vector<bool> listed;
+    const uint32_t *seqs;
+    ofstream out;
+    size_t k, m, nseqs;
+    int counts[4]={0, 0, 0, 0}, followers=0, moved=0;
+    bool finished=false;
+
+    if(stat(ckptname.c_str(), &ck)==0 && (stat(oename.c_str(), &sb)!=0 || ck.st_mtime>=sb.st_mtime) && readoefile(ckptname, st, oe)==true)
+        cout << "Resuming from " << ckptname << "." << endl;
+    else if(readoefile(oename, st, oe)==false || oe.size()==0){
+        cout << oename << " could not be read!" << endl;
+        return;
+    }
+    for(k=0;k<oe.size();k++)
+        if(oe[k].state==oeopen)
+            todo.push_back(k);
+    cout << "Advancing " << todo.size() << " open-ended sequences on " << nthreads << " threads.  This will take a long time." << endl;
+    cyclefind(st, "");
+    thread saver([&](){
+        unique_lock<mutex> hold(lock);
+        vector<struct oestate> copy;
+
+        while(finished==false){
+            wake.wait_for(hold, chrono::seconds(60));
+            copy=oe;
+            hold.unlock();
+            writeoefile(ckptname, copy);
+            hold.lock();
+        }
+    });
+    parallelfor(nthreads, todo.size(), [&](int t, int){
+        advanceoe(st, oe[todo[t]], lock, 1000);
+    });
+    {
+        lock_guard<mutex> hold(lock);
+        finished=true;
+        wake.notify_all();
+    }
+    saver.join();
+    writeoefile(ckptname, oe);
+
+    sort(oe.begin(), oe.end(), [](const struct oestate &a, const struct oestate &b){ return a.seq<b.seq; });
+    listed.assign(st.seqscount, false);
+    for(k=0;k<oe.size();k++)
+        listed[oe[k].seq]=true;
+    for(k=0;k<oe.size();k++){
+        counts[oe[k].state]++;
+        if(oe[k].moved==false)
+            continue;
+        rows.emplace_back(oe[k].seq, oerow(st, oe[k]));
+        moved++;
+        if(oe[k].state==oeopen)
+            continue;
+        // the open sequences that merge with this one now end as it does
+        nseqs=elDseqs(st, st.elD[oe[k].seq], seqs);
+        for(m=0;m<nseqs;m++){
+            if(listed[seqs[m]]==false && st.elB[seqs[m]]==0){
+                rows.emplace_back(seqs[m], followrow(st, seqs[m], oe[k]));
+                followers++;
+            }
+        }
+    }
+    sort(rows.begin(), rows.end());
+    out.open(infile+".update", std::ios_base::app);
+    out << "# createupdate batch of " << oe.size() << " sequences" << "\n";
+    for(k=0;k<rows.size();k++)
+        out << rows[k].second << "\n";
+    out.close();
+    if(out.fail()){
+        cout << infile << ".update could not be written; the progress is kept in " << ckptname << "." << endl;
+        return;
+    }
+    // the rows written are done with, and finished sequences need no more work
+    for(k=0;k<oe.size();k++)
+        oe[k].moved=false;
+    oe.erase(remove_if(oe.begin(), oe.end(), [](const struct oestate &s){ return s.state!=oeopen; }), oe.end());
+    writeoefile(ckptname, oe);
+    cout << "Open: " << counts[oeopen] << ", ended with a prime: " << counts[oeprime] << ", ended in a cycle: " << counts[oecycle] << ", merged: " << counts[oemerge] << endl;
+    cout << moved << " updated sequences and " << followers << " sequences merging with them added to " << infile << ".update." << endl;
+    applyoverlay(infile, st);
+
+    return;
+}
+
+// Routine to display help information
+void helptext(){
+    cout << "--Available options for the following prompts--" << endl;
+    cout << "(##/a/a name/h/p/p##/q/s/u): prompt" << endl;
+    cout << "    ## displays info for sequence ## if it is within the range." << endl;
+    cout << "    a brings up an advanced input routine." << endl;
+    cout << "    a name runs the advanced routine on the saved set name" << endl;
+    cout << "      (last is always the most recent list of results)." << endl;
+    cout << "    h provides this text block." << endl;
+    cout << "    p lists counts of all primes that terminate" << endl;
+    cout << "      a sequence within the limit of regina_file." << endl;
+    cout << "      Due to the large return count, the list is" << endl;
+    cout << "      sent to a primescount.txt file.  This file is" << endl;
+    cout << "      overwritten with each run." << endl;
+    cout << "    p## searches for sequences that terminate with the prime ##." << endl;
+    cout << "    s lists the saved sets of results." << endl;
+    cout << "    s name saves the most recent results as name." << endl;
+    cout << "    s name=x&y saves the sequences in both sets x and y," << endl;
+    cout << "      s name=x|y those in either and s name=x-y those in x but not y." << endl;
+    cout << "    s -name removes the set name." << endl;
+    cout << "    stats shows the time spent so far loading, searching and" << endl;
+    cout << "      listing, with counts of rows, bytes read and allocations." << endl;
+    cout << "    u run a routine to make a file of updates (<filename>.update)." << endl;
+    cout << "      The file OE_3000000_C80.txt must be available." << endl;
+    cout << "      This will take a long time.  The updates are added" << endl;
+    cout << "      to the end of the file and used from then on.  Progress" << endl;
+    cout << "      is saved in OE_3000000_C80.txt.ckpt and picked up again" << endl;
+    cout << "      by the next run, until OE_3000000_C80.txt is replaced." << endl;
+    cout << "(y/n/c/f): prompt" << endl;
+    cout << "    y performs the procedure referenced." << endl;
+    cout << "    n negative response. (default if an entry is omitted, except for Advanced)" << endl;
+    cout << "    c provides a count only, without a listing." << endl;
+    cout << "    f provides a listing to screen and to results.txt." << endl;
+    cout << "      (results.txt is never removed by the program." << endl;
+    cout << "      It is only appended to.  It has to be manually deleted.)" << endl;
+    return;
+}
+
+// Routine to compare two elD values as numbers
+// Values are decimal integers without leading zeros, so a shorter value is
+// smaller and values of equal length compare as text.
+bool numericless(string_view a, string_view b){
+    if(a.length()!=b.length())
+        return a.length()<b.length();
+    return a<b;
+}
+
+// Routine to count the sequences ending with each prime over the whole table
+// Each thread counts the prime endings of its share of the rows into its own
+// table indexed by dictionary id (elD is interned, so the id is a perfect
+// hash of the prime).  The partial tables are then summed in parallel, each
+// thread merging one slice of ids, and the primes found are sorted by value
+// into plist, with plcount holding the count of each id.
+void primecensus(struct seqtable &st, int nthreads, vector<uint32_t> &plist, vector<int> &plcount){
+    vector<vector<int>> partial;
+    uint64_t start=phasestart();
+    int nblocks, slice;
+    uint32_t k;
+
+    perf.scanned+=st.seqscount-2;
+    if(nthreads>st.seqscount/65536+1)
+        nthreads=st.seqscount/65536+1;
+    partial.resize(nthreads);
+    nblocks=(st.seqscount+65535)/65536;
+    parallelfor(nthreads, nblocks, [&](int t, int tid){
+        int i, to=(t+1)*65536;
+
+        if(partial[tid].size()==0)
+            partial[tid].assign(st.dict.count, 0);
+        if(to>st.seqscount)
+            to=st.seqscount;
+        for(i=(t==0) ? 2 : t*65536;i<to;i++)
+            if(st.elB[i]==1)
+                partial[tid][st.elD[i]]++;
+    });
+    plcount.assign(st.dict.count, 0);
+    slice=st.dict.count/nthreads+1;
+    parallelfor(nthreads, nthreads, [&](int t, int){
+        uint32_t id, to=(t+1)*slice;
+        size_t p;
+
+        if(to>st.dict.count)
+            to=st.dict.count;
+        for(p=0;p<partial.size();p++)
+            if(partial[p].size()>0)
+                for(id=t*slice;id<to;id++)
+                    plcount[id]+=partial[p][id];
+    });
+    plist.clear();
+    for(k=0;k<st.dict.count;k++)
+        if(plcount[k]>0)
+            plist.push_back(k);
+    sort(plist.begin(), plist.end(), [&](uint32_t a, uint32_t b){
+        return numericless(dictvalue(st, a), dictvalue(st, b));
+    });
+    phaseend(phasecensus, start);
+
+    return;
+}
+
+// Routine to list and count all prime terminations for entire regina_file range
+// The counts come from primecensus() and are written to primescount.txt.
+void primeslist(struct seqtable &st, int nthreads){
+    ofstream pout;
+    vector<int> plcount;
+    vector<uint32_t> plist;
+    uint64_t liststart;
+    uint32_t k;
+
+    auto start = std::chrono::system_clock::now();
+
+    primecensus(st, nthreads, plist, plcount);
+
+    liststart=phasestart();
+    pout.open("primescount.txt");
+    if(pout.is_open()){
+        for(k=0;k<plist.size();k++)
+            pout << dictvalue(st, plist[k]) << ": " << plcount[plist[k]] << "\n";
+        pout.close();
+    }
+    else
+        cout << "primescount.txt did not open properly!" << endl;
+    phaseend(phaselisting, liststart);
+
+    cout << plist.size() << " unique primes found!" << endl;
+
+    auto end = std::chrono::system_clock::now();
+    std::chrono::duration<double> elapsed = end - start;
+    cout << "Listing took " << int(elapsed.count()*1000+.5) << " ms to generate." << endl;
+
+    return;
+}
+
+// Routine to AND a selection mask with a range test on a column
+// Bit k of mask[w] stands for row w*64+k of the block col points at.  A row
+// stays selected while !(col[k]<lo || col[k]>hi), the test of the original
+// filter loop, so a NaN passes every range.  Words already zero are skipped.
+template<typename T>
+void rangescalar(const T *col, int n, T lo, T hi, uint64_t *mask){
+    uint64_t m;
+    int k, len, w;
+
+    for(w=0;w*64<n;w++){
+        if(mask[w]==0)
+            continue;
+        len=(n-w*64<64) ? n-w*64 : 64;
+        m=0;
+        for(k=0;k<len;k++)
+            m|=(uint64_t)!(col[w*64+k]<lo || col[w*64+k]>hi)<<k;
+        mask[w]&=m;
+    }
+
+    return;
+}
+
+#if defined(__x86_64__)
+// AVX2 versions of rangescalar()
+// Unsigned columns are biased into signed range so the signed compares apply.
+__attribute__((target("avx2")))
+void rangeavx2i8(const int8_t *col, int n, int8_t lo, int8_t hi, uint64_t *mask){
+    __m256i vlo=_mm256_set1_epi8(lo), vhi=_mm256_set1_epi8(hi), v, out;
+    uint64_t m;
+    int h, w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        m=0;
+        for(h=0;h<2;h++){
+            v=_mm256_loadu_si256((const __m256i *)(col+w*64+h*32));
+            out=_mm256_or_si256(_mm256_cmpgt_epi8(vlo, v), _mm256_cmpgt_epi8(v, vhi));
+            m|=(uint64_t)(uint32_t)~_mm256_movemask_epi8(out)<<(h*32);
+        }
+        mask[w]&=m;
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+__attribute__((target("avx2")))
+void rangeavx2u8(const uint8_t *col, int n, uint8_t lo, uint8_t hi, uint64_t *mask){
+    __m256i bias=_mm256_set1_epi8((char)0x80), v, out;
+    __m256i vlo=_mm256_set1_epi8((char)(lo^0x80)), vhi=_mm256_set1_epi8((char)(hi^0x80));
+    uint64_t m;
+    int h, w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        m=0;
+        for(h=0;h<2;h++){
+            v=_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(col+w*64+h*32)), bias);
+            out=_mm256_or_si256(_mm256_cmpgt_epi8(vlo, v), _mm256_cmpgt_epi8(v, vhi));
+            m|=(uint64_t)(uint32_t)~_mm256_movemask_epi8(out)<<(h*32);
+        }
+        mask[w]&=m;
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+__attribute__((target("avx2")))
+void rangeavx2u16(const uint16_t *col, int n, uint16_t lo, uint16_t hi, uint64_t *mask){
+    __m256i bias=_mm256_set1_epi16((short)0x8000), v0, v1, out0, out1;
+    __m256i vlo=_mm256_set1_epi16((short)(lo^0x8000)), vhi=_mm256_set1_epi16((short)(hi^0x8000));
+    uint64_t m;
+    int h, w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        m=0;
+        for(h=0;h<2;h++){
+            v0=_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(col+w*64+h*32)), bias);
+            v1=_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(col+w*64+h*32+16)), bias);
+            out0=_mm256_or_si256(_mm256_cmpgt_epi16(vlo, v0), _mm256_cmpgt_epi16(v0, vhi));
+            out1=_mm256_or_si256(_mm256_cmpgt_epi16(vlo, v1), _mm256_cmpgt_epi16(v1, vhi));
+            // pack the 16 bit lanes to bytes and undo the per-lane interleave of packs
+            out0=_mm256_permute4x64_epi64(_mm256_packs_epi16(out0, out1), 0xD8);
+            m|=(uint64_t)(uint32_t)~_mm256_movemask_epi8(out0)<<(h*32);
+        }
+        mask[w]&=m;
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+__attribute__((target("avx2")))
+void rangeavx2u32(const uint32_t *col, int n, uint32_t lo, uint32_t hi, uint64_t *mask){
+    __m256i bias=_mm256_set1_epi32((int)0x80000000), v, out;
+    __m256i vlo=_mm256_set1_epi32((int)(lo^0x80000000)), vhi=_mm256_set1_epi32((int)(hi^0x80000000));
+    uint64_t m;
+    int h, w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        m=0;
+        for(h=0;h<8;h++){
+            v=_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(col+w*64+h*8)), bias);
+            out=_mm256_or_si256(_mm256_cmpgt_epi32(vlo, v), _mm256_cmpgt_epi32(v, vhi));
+            m|=(uint64_t)(~_mm256_movemask_ps(_mm256_castsi256_ps(out))&0xFF)<<(h*8);
+        }
+        mask[w]&=m;
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+__attribute__((target("avx2")))
+void rangeavx2f64(const double *col, int n, double lo, double hi, uint64_t *mask){
+    __m256d vlo=_mm256_set1_pd(lo), vhi=_mm256_set1_pd(hi), v, out;
+    uint64_t m;
+    int h, w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        m=0;
+        for(h=0;h<16;h++){
+            v=_mm256_loadu_pd(col+w*64+h*4);
+            out=_mm256_or_pd(_mm256_cmp_pd(v, vlo, _CMP_LT_OQ), _mm256_cmp_pd(v, vhi, _CMP_GT_OQ));
+            m|=(uint64_t)(~_mm256_movemask_pd(out)&0xF)<<(h*4);
+        }
+        mask[w]&=m;
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+// AVX-512 versions of rangescalar()
+// The compares produce bit masks directly, one 64 row word per 64 bytes read.
+__attribute__((target("avx512f,avx512bw")))
+void rangeavx512i8(const int8_t *col, int n, int8_t lo, int8_t hi, uint64_t *mask){
+    __m512i vlo=_mm512_set1_epi8(lo), vhi=_mm512_set1_epi8(hi), v;
+    int w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        v=_mm512_loadu_si512(col+w*64);
+        mask[w]&=~(_mm512_cmplt_epi8_mask(v, vlo)|_mm512_cmpgt_epi8_mask(v, vhi));
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void rangeavx512u8(const uint8_t *col, int n, uint8_t lo, uint8_t hi, uint64_t *mask){
+    __m512i vlo=_mm512_set1_epi8((char)lo), vhi=_mm512_set1_epi8((char)hi), v;
+    int w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        v=_mm512_loadu_si512(col+w*64);
+        mask[w]&=~(_mm512_cmplt_epu8_mask(v, vlo)|_mm512_cmpgt_epu8_mask(v, vhi));
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void rangeavx512u16(const uint16_t *col, int n, uint16_t lo, uint16_t hi, uint64_t *mask){
+    __m512i vlo=_mm512_set1_epi16((short)lo), vhi=_mm512_set1_epi16((short)hi), v;
+    uint64_t out;
+    int h, w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        out=0;
+        for(h=0;h<2;h++){
+            v=_mm512_loadu_si512(col+w*64+h*32);
+            out|=(uint64_t)(_mm512_cmplt_epu16_mask(v, vlo)|_mm512_cmpgt_epu16_mask(v, vhi))<<(h*32);
+        }
+        mask[w]&=~out;
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void rangeavx512u32(const uint32_t *col, int n, uint32_t lo, uint32_t hi, uint64_t *mask){
+    __m512i vlo=_mm512_set1_epi32((int)lo), vhi=_mm512_set1_epi32((int)hi), v;
+    uint64_t out;
+    int h, w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        out=0;
+        for(h=0;h<4;h++){
+            v=_mm512_loadu_si512(col+w*64+h*16);
+            out|=(uint64_t)(_mm512_cmplt_epu32_mask(v, vlo)|_mm512_cmpgt_epu32_mask(v, vhi))<<(h*16);
+        }
+        mask[w]&=~out;
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void rangeavx512f64(const double *col, int n, double lo, double hi, uint64_t *mask){
+    __m512d vlo=_mm512_set1_pd(lo), vhi=_mm512_set1_pd(hi), v;
+    uint64_t out;
+    int h, w;
+
+    for(w=0;w<n/64;w++){
+        if(mask[w]==0)
+            continue;
+        out=0;
+        for(h=0;h<8;h++){
+            v=_mm512_loadu_pd(col+w*64+h*8);
+            out|=(uint64_t)(_mm512_cmp_pd_mask(v, vlo, _CMP_LT_OQ)|_mm512_cmp_pd_mask(v, vhi, _CMP_GT_OQ))<<(h*8);
+        }
+        mask[w]&=~out;
+    }
+    rangescalar(col+w*64, n-w*64, lo, hi, mask+w);
+
+    return;
+}
+#endif
+
+// structure for the range kernels of one instruction set
+struct rangekernels{
+    const char *name;  // instruction set
+    void (*i8)(const int8_t *, int, int8_t, int8_t, uint64_t *);
+    void (*u8)(const uint8_t *, int, uint8_t, uint8_t, uint64_t *);
+    void (*u16)(const uint16_t *, int, uint16_t, uint16_t, uint64_t *);
+    void (*u32)(const uint32_t *, int, uint32_t, uint32_t, uint64_t *);
+    void (*f64)(const double *, int, double, double, uint64_t *);
+};
+
+const struct rangekernels scalarkernels={"scalar", rangescalar<int8_t>, rangescalar<uint8_t>, rangescalar<uint16_t>, rangescalar<uint32_t>, rangescalar<double>};
+#if defined(__x86_64__)
+const struct rangekernels avx2kernels={"avx2", rangeavx2i8, rangeavx2u8, rangeavx2u16, rangeavx2u32, rangeavx2f64};
+const struct rangekernels avx512kernels={"avx512", rangeavx512i8, rangeavx512u8, rangeavx512u16, rangeavx512u32, rangeavx512f64};
+#endif
+
+// kernels in use, set by selectkernels()
+struct rangekernels kernels=scalarkernels;
+
+// Routine to pick the widest kernels the processor supports
+// want may name an instruction set to use instead, if it is supported.
+void selectkernels(string want){
+    kernels=scalarkernels;
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && want!="scalar")
+        kernels=avx2kernels;
+    if(__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && want!="scalar" && want!="avx2")
+        kernels=avx512kernels;
+#endif
+
+    return;
+}
+
+// Routine to clamp a range to the values of an integer column type
+// Returns false if no value of the type lies in the range.
+template<typename T>
+bool typerange(double lo, double hi, T &tlo, T &thi){
+    lo=ceil(lo);
+    hi=floor(hi);
+    if(lo>hi || lo>numeric_limits<T>::max() || hi<numeric_limits<T>::min())
+        return false;
+    tlo=(lo<numeric_limits<T>::min()) ? numeric_limits<T>::min() : (T)lo;
+    thi=(hi>numeric_limits<T>::max()) ? numeric_limits<T>::max() : (T)hi;
+
+    return true;
+}
+
+// Routine to AND a selection mask with lo<=column c<=hi for rows from..from+n-1
+// from must be a multiple of 64.
+void applyrange(struct seqtable &st, int c, double lo, double hi, int from, int n, uint64_t *mask){
+    int8_t i8lo, i8hi;
+    uint8_t u8lo, u8hi;
+    uint16_t u16lo, u16hi;
+    uint32_t u32lo, u32hi;
+    bool any=true;
+
+    switch(colwidth[c]){
+        case 1:
+            if(c==colB && (any=typerange(lo, hi, i8lo, i8hi))==true)
+                kernels.i8(st.elB+from, n, i8lo, i8hi, mask);
+            else if(c!=colB && (any=typerange(lo, hi, u8lo, u8hi))==true)
+                kernels.u8((const uint8_t *)colarray(st, c)+from, n, u8lo, u8hi, mask);
+            break;
+        case 2:
+            if((any=typerange(lo, hi, u16lo, u16hi))==true)
+                kernels.u16((const uint16_t *)colarray(st, c)+from, n, u16lo, u16hi, mask);
+            break;
+        case 4:
+            if((any=typerange(lo, hi, u32lo, u32hi))==true)
+                kernels.u32((const uint32_t *)colarray(st, c)+from, n, u32lo, u32hi, mask);
+            break;
+        case 8:
+            kernels.f64((const double *)colarray(st, c)+from, n, lo, hi, mask);
+            break;
+    }
+    if(any==false)
+        memset(mask, 0, (n+63)/64*8);
+
+    return;
+}
+
+// structure for one 65536-sequence piece of a result set
+// Sequences key*65536 up to key*65536+65535 are held either as a sorted list
+// of their low 16 bits, while there are at most 4096 of them, or as a bitmap
+// of 1024 words once a list would be larger than the bitmap.
+struct setpart{
+    uint32_t key;  // high bits of every sequence in the piece
+    vector<uint16_t> list;  // low bits of the sequences, if bits is empty
+    vector<uint64_t> bits;  // bitmap of the sequences, if not empty
+};
+
+// structure for a compressed result set of sequences
+// Only pieces holding at least one sequence are kept, in increasing key order.
+struct seqset{
+    vector<struct setpart> parts;  // non-empty pieces by key
+    uint64_t count;  // number of sequences held
+};
+
+const int setlistmax=4096;
+
+// Routine to count the sequences in a piece of a result set
+uint64_t partcount(const struct setpart &sp){
+    uint64_t n=0;
+    size_t w;
+
+    if(sp.bits.empty())
+        return sp.list.size();
+    for(w=0;w<sp.bits.size();w++)
+        n+=__builtin_popcountll(sp.bits[w]);
+
+    return n;
+}
+
+// Routine to store a piece of a result set in its smaller form
+void packpart(struct setpart &sp){
+    uint64_t m;
+    size_t w;
+
+    if(sp.bits.empty() || partcount(sp)>setlistmax)
+        return;
+    sp.list.clear();
+    for(w=0;w<sp.bits.size();w++){
+        for(m=sp.bits[w];m!=0;m&=m-1)
+            sp.list.push_back(w*64+__builtin_ctzll(m));
+    }
+    sp.bits=vector<uint64_t>();
+
+    return;
+}
+
+// Routine to return the bitmap of a piece of a result set
+vector<uint64_t> partbits(const struct setpart &sp){
+    vector<uint64_t> bits;
+    size_t i;
+
+    if(!sp.bits.empty())
+        return sp.bits;
+    bits=vector<uint64_t>(1024);
+    for(i=0;i<sp.list.size();i++)
+        bits[sp.list[i]/64]|=(uint64_t)1<<(sp.list[i]%64);
+
+    return bits;
+}
+
+// Routine to add a piece to the end of a result set, dropping it if empty
+void addpart(struct seqset &s, struct setpart &sp){
+    uint64_t n;
+
+    packpart(sp);
+    n=partcount(sp);
+    if(n==0)
+        return;
+    s.count+=n;
+    s.parts.push_back(move(sp));
+
+    return;
+}
+
+// Routine to make a result set from a list of sequences in increasing order
+struct seqset setfromlist(const vector<uint32_t> &seqs){
+    struct seqset s=seqset();
+    struct setpart sp;
+    size_t i, j;
+
+    for(i=0;i<seqs.size();i=j){
+        sp=setpart();
+        sp.key=seqs[i]>>16;
+        for(j=i;j<seqs.size() && seqs[j]>>16==sp.key;j++);
+        if(j-i>setlistmax){
+            sp.bits=vector<uint64_t>(1024);
+            for(;i<j;i++)
+                sp.bits[(seqs[i]&0xffff)/64]|=(uint64_t)1<<(seqs[i]%64);
+        }
+        else{
+            for(;i<j;i++)
+                sp.list.push_back(seqs[i]&0xffff);
+        }
+        addpart(s, sp);
+    }
+
+    return s;
+}
+
+// Routine to list the sequences of a result set in increasing order
+vector<uint32_t> setlist(const struct seqset &s){
+    vector<uint32_t> seqs;
+    uint64_t m;
+    size_t i, k;
+
+    seqs.reserve(s.count);
+    for(k=0;k<s.parts.size();k++){
+        const struct setpart &sp=s.parts[k];
+        if(sp.bits.empty()){
+            for(i=0;i<sp.list.size();i++)
+                seqs.push_back((sp.key<<16)|sp.list[i]);
+        }
+        else{
+            for(i=0;i<sp.bits.size();i++){
+                for(m=sp.bits[i];m!=0;m&=m-1)
+                    seqs.push_back((sp.key<<16)+i*64+__builtin_ctzll(m));
+            }
+        }
+    }
+
+    return seqs;
+}
+
+// Routine to return the smallest sequence in a non-empty result set
+uint32_t setfirst(const struct seqset &s){
+    const struct setpart &sp=s.parts.front();
+    size_t w;
+
+    if(sp.bits.empty())
+        return (sp.key<<16)|sp.list.front();
+    for(w=0;sp.bits[w]==0;w++);
+
+    return (sp.key<<16)+w*64+__builtin_ctzll(sp.bits[w]);
+}
+
+// Routine to return the largest sequence in a non-empty result set
+uint32_t setlast(const struct seqset &s){
+    const struct setpart &sp=s.parts.back();
+    size_t w;
+
+    if(sp.bits.empty())
+        return (sp.key<<16)|sp.list.back();
+    for(w=sp.bits.size()-1;sp.bits[w]==0;w--);
+
+    return (sp.key<<16)+w*64+63-__builtin_clzll(sp.bits[w]);
+}
+
+// Routine to tell if a result set holds sequence i
+bool setcontains(const struct seqset &s, uint32_t i){
+    auto it=lower_bound(s.parts.begin(), s.parts.end(), i>>16, [](const struct setpart &sp, uint32_t key){ return sp.key<key; });
+
+    if(it==s.parts.end() || it->key!=i>>16)
+        return false;
+    if(it->bits.empty())
+        return binary_search(it->list.begin(), it->list.end(), (uint16_t)(i&0xffff));
+
+    return (it->bits[(i&0xffff)/64]>>(i%64)&1)!=0;
+}
+
+// Routine to combine two result sets
+// op is '&' for sequences in both, '|' for sequences in either and '-' for
+// sequences in x but not in y.  Two lists are merged as lists; any other pair
+// of pieces is combined a word at a time as bitmaps.
+struct seqset setcombine(const struct seqset &x, const struct seqset &y, char op){
+    struct seqset s=seqset();
+    struct setpart sp;
+    vector<uint64_t> bx, by;
+    size_t i, j, w;
+
+    i=0;
+    j=0;
+    while(i<x.parts.size() || j<y.parts.size()){
+        sp=setpart();
+        if(j==y.parts.size() || (i<x.parts.size() && x.parts[i].key<y.parts[j].key)){
+            if(op!='&')
+                sp=x.parts[i];
+            i++;
+        }
+        else if(i==x.parts.size() || y.parts[j].key<x.parts[i].key){
+            if(op=='|')
+                sp=y.parts[j];
+            j++;
+        }
+        else{
+            const struct setpart &px=x.parts[i++], &py=y.parts[j++];
+            sp.key=px.key;
+            if(px.bits.empty() && py.bits.empty()){
+                if(op=='&')
+                    set_intersection(px.list.begin(), px.list.end(), py.list.begin(), py.list.end(), back_inserter(sp.list));
+                else if(op=='|')
+                    set_union(px.list.begin(), px.list.end(), py.list.begin(), py.list.end(), back_inserter(sp.list));
+                else
+                    set_difference(px.list.begin(), px.list.end(), py.list.begin(), py.list.end(), back_inserter(sp.list));
+                if(sp.list.size()>setlistmax){
+                    sp.bits=partbits(sp);
+                    sp.list=vector<uint16_t>();
+                }
+            }
+            else{
+                bx=partbits(px);
+                by=partbits(py);
+                for(w=0;w<bx.size();w++){
+                    if(op=='&')
+                        bx[w]&=by[w];
+                    else if(op=='|')
+                        bx[w]|=by[w];
+                    else
+                        bx[w]&=~by[w];
+                }
+                sp.bits=move(bx);
+            }
+        }
+        addpart(s, sp);
+    }
+
+    return s;
+}
+
+// Routine to AND a block selection mask with the members of a result set
+// Bit i of mask stands for sequence base+i, and base must be a multiple of 64.
+// Returns false if no bit of the mask is left set.
+bool setmask(const struct seqset &s, int base, int n, uint64_t *mask){
+    uint64_t keep[64];
+    size_t k;
+    int b, e, i, lo, hi, words, w;
+    bool any=false;
+
+    words=(n+63)/64;
+    memset(keep, 0, sizeof(keep));
+    k=lower_bound(s.parts.begin(), s.parts.end(), (uint32_t)base>>16, [](const struct setpart &sp, uint32_t key){ return sp.key<key; })-s.parts.begin();
+    for(;k<s.parts.size() && (int64_t)s.parts[k].key<<16<(int64_t)base+n;k++){
+        const struct setpart &sp=s.parts[k];
+        b=(int)(sp.key<<16);
+        lo=(base>b) ? base-b : 0;
+        hi=(base+n-b<65536) ? base+n-b : 65536;
+        if(sp.bits.empty()){
+            i=lower_bound(sp.list.begin(), sp.list.end(), lo)-sp.list.begin();
+            for(;i<(int)sp.list.size() && sp.list[i]<hi;i++){
+                e=b+sp.list[i]-base;
+                keep[e/64]|=(uint64_t)1<<(e%64);
+            }
+        }
+        else{
+            for(w=lo/64;w<(hi+63)/64;w++)
+                keep[(b+w*64-base)/64]=sp.bits[w];
+        }
+    }
+    for(w=0;w<words;w++){
+        mask[w]&=keep[w];
+        if(mask[w]!=0)
+            any=true;
+    }
+
+    return any;
+}
+
+// structure for the filters of an advanced search
+// A sequence i matches when i is in c..d, i=a (mod b), it is on the previous
+// input set if one is given, and lo[k]<=column k<=hi[k] for every numeric
+// column k (elD excepted).
+struct filterspec{
+    int a, b;  // sequence filter a (mod b)
+    int c, d;  // sequence range
+    const struct seqset *input;  // only sequences in this set, if not NULL
+    double lo[ncols];  // lowest value allowed for each column
+    double hi[ncols];  // highest value allowed for each column
+};
+
+// Routine to make a filter that passes every sequence of a table
+void clearfilter(struct seqtable &st, struct filterspec &fs){
+    int k;
+
+    fs.a=0;
+    fs.b=1;
+    fs.c=2;
+    fs.d=st.seqscount-1;
+    fs.input=NULL;
+    for(k=0;k<ncols;k++){
+        fs.lo[k]=-numeric_limits<double>::infinity();
+        fs.hi[k]=numeric_limits<double>::infinity();
+    }
+
+    return;
+}
+
+// Routine to tell if a filter range can reject any row of its column
+// A range that covers everything between the column's minimum and maximum,
+// such as an untouched prompt default, is skipped by runfilter().
+bool rangeactive(struct seqtable &st, const struct filterspec &fs, int k){
+    if(k==colD)
+        return false;
+    return !(fs.lo[k]<=st.colmin[k] && fs.hi[k]>=st.colmax[k]);
+}
+
+// Routine to add the sequences of one block of rows that pass a filter to found
+// The block must lie inside one zone.  If the zone map shows that some active
+// range misses the whole zone, and the zone has no NaN in that column, the
+// block is passed over; ranges that cover the whole zone are not tested.  Otherwise a selection bitmask is seeded from
+// the sequence range and a (mod b) and then ANDed with each remaining range in
+// turn by the vector kernels, stopping early once no bit is left; the set
+// bits left over are the matches.
+void filterblock(struct seqtable &st, const struct filterspec &fs, const vector<int> &active, int base, vector<uint32_t> &found){
+    const int blockrows=4096;
+    uint64_t mask[blockrows/64], m;
+    const double *zmin, *zmax;
+    const uint8_t *znan;
+    int use[ncols], c, first, last, i, k, n, nuse, w;
+
+    zmin=st.zones.min+(size_t)(base/zonerows)*ncols;
+    zmax=st.zones.max+(size_t)(base/zonerows)*ncols;
+    znan=st.zones.nan+(size_t)(base/zonerows)*ncols;
+    nuse=0;
+    for(k=0;k<(int)active.size();k++){
+        c=active[k];
+        if(znan[c]==0 && (fs.hi[c]<zmin[c] || fs.lo[c]>zmax[c]))
+            return;
+        if(!(fs.lo[c]<=zmin[c] && fs.hi[c]>=zmax[c]))
+            use[nuse++]=c;
+    }
+    n=(st.seqscount-base<blockrows) ? st.seqscount-base : blockrows;
+    first=(base>fs.c) ? base : fs.c;
+    last=(base+n-1<fs.d) ? base+n-1 : fs.d;
+    first+=((fs.a-first%fs.b)%fs.b+fs.b)%fs.b;
+    if(first>last)
+        return;
+    perf.scanned.fetch_add((last-first)/fs.b+1, memory_order_relaxed);
+    memset(mask, 0, sizeof(mask));
+    if(fs.b==1){
+        for(i=first;i<=last && (i-base)%64!=0;i++)
+            mask[(i-base)/64]|=(uint64_t)1<<((i-base)%64);
+        for(;i+63<=last;i+=64)
+            mask[(i-base)/64]=~(uint64_t)0;
+        for(;i<=last;i++)
+            mask[(i-base)/64]|=(uint64_t)1<<((i-base)%64);
+    }
+    else{
+        for(i=first;i<=last;i+=fs.b)
+            mask[(i-base)/64]|=(uint64_t)1<<((i-base)%64);
+    }
+    if(fs.input!=NULL && setmask(*fs.input, base, n, mask)==false)
+        return;
+    for(k=0;k<nuse;k++){
+        applyrange(st, use[k], fs.lo[use[k]], fs.hi[use[k]], base, n, mask);
+        for(w=0;w<blockrows/64 && mask[w]==0;w++);
+        if(w==blockrows/64)
+            return;
+    }
+    for(w=0;w<blockrows/64;w++){
+        for(m=mask[w];m!=0;m&=m-1)
+            found.push_back(base+w*64+__builtin_ctzll(m));
+    }
+
+    return;
+}
+
+// Routine to estimate the fraction of sequences with column c in lo..hi
+// The column's histogram is used, counting bins that are partly inside the
+// range in proportion to the overlap.
+double estimatefraction(struct seqtable &st, int c, double lo, double hi){
+    const uint32_t *bins=st.hist.count+(size_t)c*histbins;
+    double blo, hlo, hhi, part, sum=0, total=0, w;
+    int j;
+
+    if(colwidth[c]<8){
+        lo=ceil(lo)-0.5;
+        hi=floor(hi)+0.5;
+    }
+    hlo=st.hist.lo[c];
+    hhi=st.hist.hi[c];
+    w=(hhi-hlo)/histbins;
+    for(j=0;j<histbins;j++){
+        total+=bins[j];
+        if(bins[j]==0)
+            continue;
+        if(w>0){
+            blo=hlo+j*w;
+            part=(min(hi, blo+w)-max(lo, blo))/w;
+        }
+        else
+            part=(lo<=hlo && hlo<=hi) ? 1 : 0;
+        if(part>0)
+            sum+=bins[j]*min(part, 1.0);
+    }
+
+    return (total>0) ? sum/total : 0;
+}
+
+// Routine to tell if sequence i passes the conditions of a filter
+// The a (mod b) test is left to the caller, as is the range on column skip.
+// The ranges are tested in the order of active, with the test of
+// rangescalar(), so a NaN passes every range here as it does in a scan.
+bool rowpasses(struct seqtable &st, const struct filterspec &fs, const vector<int> &active, int skip, int i){
+    double v;
+    int k;
+
+    if(i<fs.c || i>fs.d)
+        return false;
+    if(fs.input!=NULL && setcontains(*fs.input, i)==false)
+        return false;
+    for(k=0;k<(int)active.size();k++){
+        if(active[k]==skip)
+            continue;
+        v=colvalue(st, active[k], i);
+        if(v<fs.lo[active[k]] || v>fs.hi[active[k]])
+            return false;
+    }
+
+    return true;
+}
+
+// Routine to find the sequences that pass a filter by stepping through a (mod b)
+// Only the sequences first, first+b, ... up to last are visited, split into
+// tasks for nthreads threads whose lists of matches are joined in order.
+vector<uint32_t> stridefilter(struct seqtable &st, const struct filterspec &fs, const vector<int> &active, int64_t first, int last, int nthreads){
+    vector<uint32_t> found;
+    vector<vector<uint32_t>> parts;
+    int64_t cands=(last-first)/fs.b+1;
+    int t, tasks;
+
+    perf.scanned+=cands;
+    tasks=(nthreads>1) ? nthreads*16 : 1;
+    if(tasks>cands)
+        tasks=(int)cands;
+    parts=vector<vector<uint32_t>>(tasks);
+    parallelfor(nthreads, tasks, [&](int task, int){
+        int64_t q, qend=cands*(task+1)/tasks;
+
+        for(q=cands*task/tasks;q<qend;q++)
+            if(rowpasses(st, fs, active, -1, (int)(first+q*fs.b))==true)
+                parts[task].push_back(first+q*fs.b);
+    });
+    for(t=0;t<tasks;t++)
+        found.insert(found.end(), parts[t].begin(), parts[t].end());
+
+    return found;
+}
+
+// Routine to find the sequences that pass a filter from a column index
+// The sequences of st.sorted[c].rows[from] up to rows[to] already pass the
+// range on column c, as do those of st.sorted[c].nans; they are put in order
+// and every other condition of the filter is checked one sequence at a time.
+vector<uint32_t> indexfilter(struct seqtable &st, const struct filterspec &fs, const vector<int> &active, int c, size_t from, size_t to){
+    const struct colindex &ci=st.sorted[c];
+    vector<uint32_t> cand(ci.rows.begin()+from, ci.rows.begin()+to), found;
+    size_t z;
+
+    cand.insert(cand.end(), ci.nans.begin(), ci.nans.end());
+    perf.scanned+=cand.size();
+    sort(cand.begin(), cand.end());
+    for(z=0;z<cand.size();z++)
+        if((int)cand[z]%fs.b==fs.a && rowpasses(st, fs, active, c, cand[z])==true)
+            found.push_back(cand[z]);
+
+    return found;
+}
+
+// structure for the way a search will be carried out, chosen by planfilter()
+enum{plannone, planindex, planstride, planscan};
+struct filterplan{
+    int how;  // plannone (nothing can match), planindex, planstride or planscan
+    vector<int> active;  // columns whose ranges must be tested, narrowest first
+    int c, d;  // sequence range, narrowed to the input set
+    int64_t first;  // first sequence in c..d that is a (mod b)
+    int64_t cands;  // sequences in c..d that are a (mod b)
+    int best;  // column whose index is used by planindex
+    size_t from, to;  // run of the index that passes its range
+    size_t nans;  // sequences with NaN in column best, which pass as well
+};
+
+// Routine to choose how a filter will be searched
+// The active ranges are ordered by the share of sequences the histograms
+// expect them to pass, narrowest first.  Then the cheapest of three plans is
+// taken: checking the sequences of the narrowest range found in a column index,
+// stepping through a (mod b) when b leaves fewer than 1/32 of the rows, or
+// scanning the blocks.  Only the narrowest range may build its index, and only
+// when the histogram expects fewer than 1/32 of the sequences to pass and the
+// table is not frozen; the other ranges use indexes that are already built.
+struct filterplan planfilter(struct seqtable &st, const struct filterspec &fs){
+    struct filterplan fp;
+    double est[ncols];
+    size_t from, nans, to;
+    int k;
+
+    fp.how=plannone;
+    fp.best=-1;
+    fp.from=0;
+    fp.to=0;
+    fp.nans=0;
+    fp.c=fs.c;
+    fp.d=fs.d;
+    if(fs.input!=NULL){
+        if(fs.input->count==0)
+            return fp;
+        fp.c=max(fp.c, (int)setfirst(*fs.input));
+        fp.d=min(fp.d, (int)setlast(*fs.input));
+    }
+    if(fs.b<1 || fs.a>=fs.b || fp.c>fp.d)
+        return fp;
+    fp.first=fp.c+((fs.a-fp.c%fs.b)%fs.b+fs.b)%fs.b;
+    if(fp.first>fp.d)
+        return fp;
+    fp.cands=(fp.d-fp.first)/fs.b+1;
+    for(k=0;k<ncols;k++){
+        if(rangeactive(st, fs, k)==true){
+            fp.active.push_back(k);
+            est[k]=estimatefraction(st, k, fs.lo[k], fs.hi[k]);
+        }
+    }
+    stable_sort(fp.active.begin(), fp.active.end(), [&est](int x, int y){ return est[x]<est[y]; });
+    for(k=0;k<(int)fp.active.size();k++){
+        if(st.sorted[fp.active[k]].built==false && (k>0 || st.frozen==true || est[fp.active[k]]*32>=1))
+            continue;
+        buildcolindex(st, fp.active[k]);
+        indexrange(st, fp.active[k], fs.lo[fp.active[k]], fs.hi[fp.active[k]], from, to);
+        nans=st.sorted[fp.active[k]].nans.size();
+        if(fp.best<0 || to-from+nans<fp.to-fp.from+fp.nans){
+            fp.best=fp.active[k];
+            fp.from=from;
+            fp.to=to;
+            fp.nans=nans;
+        }
+    }
+    if(fp.best>=0 && (fp.to-fp.from+fp.nans)*32<(size_t)(fp.d-fp.c+1) && (int64_t)(fp.to-fp.from+fp.nans)<=fp.cands)
+        fp.how=planindex;
+    else if(fp.cands*32<(int64_t)(fp.d-fp.c+1))
+        fp.how=planstride;
+    else
+        fp.how=planscan;
+
+    return fp;
+}
+
+// Routine to find all sequences that pass a filter, in increasing order
+// fp is the plan made for the filter by planfilter().  A scan takes rows 4096
+// at a time and
+// the blocks are split into tasks holding equal numbers of a (mod b)
+// candidates, so a large b still spreads the work evenly over nthreads
+// threads.  Each task keeps its own list of matches and the lists are joined
+// in task order, which leaves the result sorted.  With an input set only the
+// blocks between its first and last sequence are visited.  Blocks start on
+// multiples of 4096 so none of them straddles two zones.
+vector<uint32_t> runplan(struct seqtable &st, const struct filterspec &fs, const struct filterplan &fp, int nthreads){
+    const int blockrows=4096;
+    vector<uint32_t> found;
+    vector<vector<uint32_t>> parts;
+    vector<int> bound;
+    int64_t q;
+    int base0, blocks, t, tasks;
+    size_t total;
+
+    if(fp.how==plannone)
+        return found;
+    if(fp.how==planindex)
+        return indexfilter(st, fs, fp.active, fp.best, fp.from, fp.to);
+    if(fp.how==planstride)
+        return stridefilter(st, fs, fp.active, fp.first, fp.d, nthreads);
+    base0=fp.c/blockrows*blockrows;
+    blocks=(fp.d-base0)/blockrows+1;
+    tasks=(nthreads>1) ? nthreads*16 : 1;
+    if(tasks>blocks)
+        tasks=blocks;
+    if(tasks>fp.cands)
+        tasks=(int)fp.cands;
+    bound=vector<int>(tasks+1);
+    for(t=0;t<tasks;t++){
+        q=fp.cands*t/tasks;
+        bound[t]=(t==0) ? 0 : (int)((fp.first+q*fs.b-base0)/blockrows);
+    }
+    bound[tasks]=blocks;
+    parts=vector<vector<uint32_t>>(tasks);
+    parallelfor(nthreads, tasks, [&](int task, int){
+        int j;
+
+        for(j=bound[task];j<bound[task+1];j++)
+            filterblock(st, fs, fp.active, base0+j*blockrows, parts[task]);
+    });
+    total=0;
+    for(t=0;t<tasks;t++)
+        total+=parts[t].size();
+    found.reserve(total);
+    for(t=0;t<tasks;t++)
+        found.insert(found.end(), parts[t].begin(), parts[t].end());
+
+    return found;
+}
+
+// Routine to plan and run a filter
+vector<uint32_t> runfilter(struct seqtable &st, const struct filterspec &fs, int nthreads){
+    vector<uint32_t> found;
+    uint64_t start=phasestart();
+
+    found=runplan(st, fs, planfilter(st, fs), nthreads);
+    perf.matched+=found.size();
+    phaseend(phasesearch, start);
+
+    return found;
+}
+
+// Routine to find the sequences that pass each of several filters
+// Filters that planfilter() sends to a scan share a single sweep: every block
+// of rows is run through all of them while its columns are still in cache,
+// instead of making one pass over the table per filter.  The others are run
+// on their own by runplan().  found[q] receives the matches of specs[q].
+void runfilters(struct seqtable &st, const vector<struct filterspec> &specs, vector<vector<uint32_t>> &found, int nthreads){
+    const int blockrows=4096;
+    vector<struct filterplan> plans(specs.size());
+    vector<vector<vector<uint32_t>>> parts;
+    vector<int> scans;
+    int base0=numeric_limits<int>::max(), blocks, last=0, tasks;
+    size_t q, t, total;
+
+    found=vector<vector<uint32_t>>(specs.size());
+    for(q=0;q<specs.size();q++){
+        plans[q]=planfilter(st, specs[q]);
+        if(plans[q].how==planscan){
+            scans.push_back(q);
+            base0=min(base0, plans[q].c/blockrows*blockrows);
+            last=max(last, plans[q].d);
+        }
+        else if(plans[q].how!=plannone)
+            found[q]=runplan(st, specs[q], plans[q], nthreads);
+    }
+    if(scans.empty())
+        return;
+    blocks=(last-base0)/blockrows+1;
+    tasks=(nthreads>1) ? nthreads*16 : 1;
+    if(tasks>blocks)
+        tasks=blocks;
+    parts=vector<vector<vector<uint32_t>>>(tasks, vector<vector<uint32_t>>(scans.size()));
+    parallelfor(nthreads, tasks, [&](int task, int){
+        int base, j, jend=(int)((int64_t)blocks*(task+1)/tasks);
+        size_t s;
+
+        for(j=(int)((int64_t)blocks*task/tasks);j<jend;j++){
+            base=base0+j*blockrows;
+            for(s=0;s<scans.size();s++){
+                const struct filterplan &fp=plans[scans[s]];
+                if(base<=fp.d && base+blockrows>fp.c)
+                    filterblock(st, specs[scans[s]], fp.active, base, parts[task][s]);
+            }
+        }
+    });
+    for(q=0;q<scans.size();q++){
+        total=0;
+        for(t=0;t<parts.size();t++)
+            total+=parts[t][q].size();
+        found[scans[q]].reserve(total);
+        for(t=0;t<parts.size();t++)
+            found[scans[q]].insert(found[scans[q]].end(), parts[t][q].begin(), parts[t][q].end());
+    }
+
+    return;
+}
+
+// Routine to perform advanced searches of data
+// The search covers the sequences of input, or the whole table if input is
+// NULL, and its matches become the last results.
+void advanced(struct seqtable &st, const struct seqset *input, struct seqset &last, int nthreads){
+    struct resultwriter aout, screen;
+    string sf1, sf2, sf3, temp, yn;
+    char *dp;
+    size_t found;
+    struct filterspec fs;
+    vector<uint32_t> matches;
+    uint64_t start;
+    size_t z;
+    int a, b, c, d, e, f, g, h, j, k, l, m, n, o, p, q, r, s, t, u, v, w, x, rcount;
+    double da, db, dc, dd, de, df, dg, dh, di, dj, dk, dl;
+
+    if(input!=NULL)
+        cout << "Advanced Routine using previous results" << endl;
+    else
+        cout << "Advanced Routine" << endl;
+    cout << "Sequence filter a (mod b) (a b): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            a=atoi(temp.substr(0,found).c_str());
+            b=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            a=0;
+            b=atoi(temp.c_str());
+        }
+    }
+    else{
+        a=0;
+        b=1;
+    }
+    if(a<0)
+        a=0;
+    if(b>st.seqscount-1)
+        b=st.seqscount-1;
+    cout << "Sequence range (begin end): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            c=atoi(temp.substr(0,found).c_str());
+            d=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            c=atoi(temp.c_str());
+            d=c;
+        }
+    }
+    else{
+        c=2;
+        d=st.seqscount-1;
+    }
+    if(c<2)
+        c=2;
+    if(d>st.seqscount-1)
+        d=st.seqscount-1;
+    cout << "All, Prime, Open, Cylce (a/p/o/c): ";
+    getline(cin, temp);
+    if(temp.substr(0,1)=="p")
+        e=1;
+    else if(temp.substr(0,1)=="o")
+        e=0;
+    else if(temp.substr(0,1)=="c")
+        e=-1;
+    else
+        e=2;
+    cout << "Range for number of iterations (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            w=atoi(temp.substr(0,found).c_str());
+            x=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            w=atoi(temp.c_str());
+            x=w;
+        }
+    }
+    else{
+        w=0;
+        x=30000;
+    }
+    if(w<0)
+        w=0;
+    cout << "Range for number of relative minimums (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            f=atoi(temp.substr(0,found).c_str());
+            g=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            f=atoi(temp.c_str());
+            g=f;
+        }
+    }
+    else{
+        f=0;
+        g=10000;
+    }
+    if(f<0)
+        f=0;
+    cout << "Range for number of relative maximums (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            h=atoi(temp.substr(0,found).c_str());
+            j=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            h=atoi(temp.c_str());
+            j=h;
+        }
+    }
+    else{
+        h=0;
+        j=10000;
+    }
+    if(h<0)
+        h=0;
+    cout << "Range for number of parity changes (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            k=atoi(temp.substr(0,found).c_str());
+            l=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            k=atoi(temp.c_str());
+            l=k;
+        }
+    }
+    else{
+        k=0;
+        l=10000;
     }
     if(k<0)
         k=0;
@@ -366,495 +4333,1798 @@ void advanced(struct seqdata seqd[], struct seqdatad seqdd[], int seqscount, boo
     if(temp.length()>0){
         found=temp.find(" ");
         if(found!=string::npos){
-            q=atoi(temp.substr(0,found).c_str());
-            r=atoi(temp.substr(found+1).c_str());
+            q=atoi(temp.substr(0,found).c_str());
+            r=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            q=atoi(temp.c_str());
+            r=q;
+        }
+    }
+    else{
+        q=0;
+        r=10000;
+    }
+    if(q<0)
+        q=0;
+    cout << "Range for number of consecutive odd abundant terms (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            s=atoi(temp.substr(0,found).c_str());
+            t=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            s=atoi(temp.c_str());
+            t=s;
+        }
+    }
+    else{
+        s=0;
+        t=10000;
+    }
+    if(s<0)
+        s=0;
+    cout << "Range for number of downdriver extracts (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            u=atoi(temp.substr(0,found).c_str());
+            v=atoi(temp.substr(found+1).c_str());
+        }
+        else{
+            u=atoi(temp.c_str());
+            v=s;
+        }
+    }
+    else{
+        u=0;
+        v=10000;
+    }
+    if(u<0)
+        u=0;
+    cout << "Range for smallest quotient of two consecutive terms (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            da=strtod(temp.substr(0,found).c_str(), &dp);
+            db=strtod(temp.substr(found+1).c_str(), &dp);
+        }
+        else{
+            da=strtod(temp.c_str(), &dp);
+            db=da;
+        }
+    }
+    else{
+        da=0;
+        db=10000;
+    }
+    if(da<0)
+        da=0;
+    cout << "Range for largest quotient of two consecutive terms (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            dc=strtod(temp.substr(0,found).c_str(), &dp);
+            dd=strtod(temp.substr(found+1).c_str(), &dp);
+        }
+        else{
+            dc=strtod(temp.c_str(), &dp);
+            dd=dc;
+        }
+    }
+    else{
+        dc=0;
+        dd=10000;
+    }
+    if(dc<0)
+        dc=0;
+    cout << "Range for arith mean of all quotients of 2 consequtive terms (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            de=strtod(temp.substr(0,found).c_str(), &dp);
+            df=strtod(temp.substr(found+1).c_str(), &dp);
+        }
+        else{
+            de=strtod(temp.c_str(), &dp);
+            df=de;
+        }
+    }
+    else{
+        de=0;
+        df=10000;
+    }
+    if(de<0)
+        de=0;
+    cout << "Range for geo mean of all quotients of 2 consequtive terms (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            dg=strtod(temp.substr(0,found).c_str(), &dp);
+            dh=strtod(temp.substr(found+1).c_str(), &dp);
+        }
+        else{
+            dg=strtod(temp.c_str(), &dp);
+            dh=dg;
+        }
+    }
+    else{
+        dg=0;
+        dh=10000;
+    }
+    if(dg<0)
+        dg=0;
+    cout << "Range for arith mean of # of digits of all the mins (min max): ";
+    getline(cin, temp);
+    if(temp.length()>0){
+        found=temp.find(" ");
+        if(found!=string::npos){
+            di=strtod(temp.substr(0,found).c_str(), &dp);
+            dj=strtod(temp.substr(found+1).c_str(), &dp);
         }
         else{
-            q=atoi(temp.c_str());
-            r=q;
+            di=strtod(temp.c_str(), &dp);
+            dj=di;
         }
     }
     else{
-        q=0;
-        r=10000;
+        di=0;
+        dj=10000;
     }
-    if(q<0)
-        q=0;
-    cout << "Range for number of consecutive odd abundant terms (min max): ";
+    if(di<0)
+        di=0;
+    cout << "Range for arith mean of # of digits of all the maxes (min max): ";
     getline(cin, temp);
     if(temp.length()>0){
         found=temp.find(" ");
         if(found!=string::npos){
-            s=atoi(temp.substr(0,found).c_str());
-            t=atoi(temp.substr(found+1).c_str());
+            dk=strtod(temp.substr(0,found).c_str(), &dp);
+            dl=strtod(temp.substr(found+1).c_str(), &dp);
         }
         else{
-            s=atoi(temp.c_str());
-            t=s;
+            dk=strtod(temp.c_str(), &dp);
+            dl=dk;
         }
     }
     else{
-        s=0;
-        t=10000;
+        dk=0;
+        dl=10000;
     }
-    if(s<0)
-        s=0;
-    cout << "Range for number of downdriver extracts (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            u=atoi(temp.substr(0,found).c_str());
-            v=atoi(temp.substr(found+1).c_str());
+    if(dk<0)
+        dk=0;
+
+    cout << "List filtered sequences for " << a << " (mod " << b << ") from " << c << " through " << d << "? (y/n/c/f): ";
+    getline(cin, yn);
+    if(yn.substr(0,1)=="n")
+        return;
+    clearfilter(st, fs);
+    fs.a=a;
+    fs.b=b;
+    fs.c=c;
+    fs.d=d;
+    fs.input=input;
+    if(e!=2){
+        fs.lo[colB]=e;
+        fs.hi[colB]=e;
+    }
+    fs.lo[colC]=w; fs.hi[colC]=x;
+    fs.lo[colG]=f; fs.hi[colG]=g;
+    fs.lo[colH]=h; fs.hi[colH]=j;
+    fs.lo[colI]=k; fs.hi[colI]=l;
+    fs.lo[colJ]=m; fs.hi[colJ]=n;
+    fs.lo[colK]=o; fs.hi[colK]=p;
+    fs.lo[colL]=q; fs.hi[colL]=r;
+    fs.lo[colM]=s; fs.hi[colM]=t;
+    fs.lo[colN]=u; fs.hi[colN]=v;
+    fs.lo[colO]=da; fs.hi[colO]=db;
+    fs.lo[colP]=dc; fs.hi[colP]=dd;
+    fs.lo[colQ]=de; fs.hi[colQ]=df;
+    fs.lo[colR]=dg; fs.hi[colR]=dh;
+    fs.lo[colS]=di; fs.hi[colS]=dj;
+    fs.lo[colT]=dk; fs.hi[colT]=dl;
+    matches=runfilter(st, fs, nthreads);
+    last=setfromlist(matches);
+
+    start=phasestart();
+    if(yn.substr(0,1)=="f" && openwriterfile(aout, "results.txt", true, fmtlines)==true)
+        writertext(aout, "All filtered sequences for "+to_string(a)+" (mod "+to_string(b)+") from "+to_string(c)+" through "+to_string(d)+":\n");
+    if(yn.substr(0,1)!="c")
+        openwriter(screen, STDOUT_FILENO, false, fmtcolumns);
+    rcount=0;
+    for(z=0;z<matches.size();z++){
+        writerid(aout, matches[z]);
+        writerid(screen, matches[z]);
+        rcount++;
+    }
+    if(rcount>0)
+        writertext(screen, "\n");
+    closewriter(aout);
+    closewriter(screen);
+    phaseend(phaselisting, start);
+    if(rcount!=1)
+        cout << rcount << " sequences found." << endl;
+    else
+        cout << rcount << " sequence found." << endl;
+
+    return;
+
+}
+
+// This routine finds all sequences that terminate with the supplied prime
+// The sequences found become the last results.
+void primesfind(struct seqtable &st, int seqn, struct seqset &last, int nthreads){
+    string_view dval=dictvalue(st, st.elD[seqn]);
+    string yn;
+    struct resultwriter out, screen;
+    const uint32_t *seqs;
+    vector<uint32_t> listed;
+    struct seqset prev;
+    uint64_t start;
+    size_t k, nseqs;
+    int j, rcount;
+
+    cout << "List all sequences that terminate with " << dval << "? (y/n/c/f): ";
+    getline(cin, yn);
+    if(yn.substr(0,1)=="y" || yn.substr(0,1)=="f" || yn.substr(0,1)=="c"){
+        start=phasestart();
+        if(yn.substr(0,1)=="f" && openwriterfile(out, "results.txt", true, fmtlines)==true)
+            writertext(out, "All sequences that terminate with "+string(dval)+":\n");
+        if(yn!="c")
+            openwriter(screen, STDOUT_FILENO, false, fmtcolumns);
+        rcount=0;
+        nseqs=elDseqs(st, st.elD[seqn], seqs);
+        for(k=0;k<nseqs;k++){
+            j=seqs[k];
+            writerid(out, j);
+            writerid(screen, j);
+            listed.push_back(j);
+            rcount++;
+        }
+        last=setfromlist(listed);
+        writertext(screen, "\n");
+        closewriter(out);
+        closewriter(screen);
+        perf.scanned+=nseqs;
+        perf.matched+=rcount;
+        phaseend(phaselisting, start);
+        if(rcount>1){
+            cout << rcount << " sequences found." << endl;
+            cout << "Perform Advanced Filtering on these results? (y/n): ";
+            getline(cin, yn);
+            if(yn.substr(0,1)=="y"){
+                prev=last;
+                advanced(st, &prev, last, nthreads);
+            }
+        }
+        else
+            cout << rcount << " sequence found." << endl;
+    }
+    return;
+}
+
+// Routine to strip leading and trailing spaces from a command argument
+string settrim(string s){
+    size_t b, e;
+
+    b=s.find_first_not_of(" ");
+    if(b==string::npos)
+        return "";
+    e=s.find_last_not_of(" ");
+
+    return s.substr(b, e-b+1);
+}
+
+// Routine to look up a result set by name
+// The name last always refers to the last results.  Returns NULL if there is
+// no set of that name.
+const struct seqset *findset(const map<string, struct seqset> &sets, const struct seqset &last, string name){
+    auto it=sets.find(name);
+
+    if(name=="last")
+        return &last;
+    if(it==sets.end())
+        return NULL;
+
+    return &it->second;
+}
+
+// Routine to tell if a name can be used for a result set
+bool setname(string name){
+    size_t i;
+
+    if(name.length()==0 || name=="last")
+        return false;
+    for(i=0;i<name.length();i++)
+        if(!isalnum((unsigned char)name[i]) && name[i]!='_')
+            return false;
+
+    return true;
+}
+
+// Routine to keep, combine and drop named result sets
+// cmd is what followed s at the prompt: nothing lists the sets, name keeps the
+// last results as name, -name drops name, and name=x&y, name=x|y or name=x-y
+// stores the sequences in both, either, or only the first of sets x and y.
+void setcommand(string cmd, map<string, struct seqset> &sets, struct seqset &last){
+    const struct seqset *x, *y;
+    string name, lhs, rhs;
+    size_t eq, op;
+
+    if(cmd.length()==0){
+        cout << "last: " << last.count << " sequences" << endl;
+        for(auto it=sets.begin();it!=sets.end();it++)
+            cout << it->first << ": " << it->second.count << " sequences" << endl;
+        return;
+    }
+    if(cmd[0]=='-'){
+        name=settrim(cmd.substr(1));
+        if(sets.erase(name)==0)
+            cout << "No set named " << name << "." << endl;
+        else
+            cout << "Set " << name << " removed." << endl;
+        return;
+    }
+    eq=cmd.find("=");
+    name=settrim(cmd.substr(0, eq));
+    if(setname(name)==false){
+        cout << "Set names use letters, digits and _ only (last is reserved)." << endl;
+        return;
+    }
+    if(eq==string::npos)
+        sets[name]=last;
+    else{
+        rhs=cmd.substr(eq+1);
+        op=rhs.find_first_of("&|-");
+        if(op==string::npos){
+            cout << "Combine sets with x&y, x|y or x-y." << endl;
+            return;
+        }
+        lhs=settrim(rhs.substr(0, op));
+        if((x=findset(sets, last, lhs))==NULL){
+            cout << "No set named " << lhs << "." << endl;
+            return;
+        }
+        if((y=findset(sets, last, settrim(rhs.substr(op+1))))==NULL){
+            cout << "No set named " << settrim(rhs.substr(op+1)) << "." << endl;
+            return;
+        }
+        sets[name]=setcombine(*x, *y, rhs[op]);
+    }
+    cout << name << ": " << sets[name].count << " sequences" << endl;
+
+    return;
+}
+
+// Routine to read one condition of a batch query into a filter
+// A condition compares a field with a number using =, <, <=, > or >=.  The
+// fields are elB..elT (elD excepted; the "el" may be left off) and seq, the
+// sequence number, which also takes seq%b=a for a (mod b).  Conditions only
+// ever narrow the filter.  Returns false if the condition is not understood.
+bool parsecondition(string cond, struct filterspec &fs){
+    string field, op, value;
+    size_t p, q;
+    double v;
+    char *end;
+    int col;
+
+    p=cond.find_first_of("<>=%");
+    if(p==string::npos)
+        return false;
+    field=settrim(cond.substr(0, p));
+    for(q=0;q<field.length();q++)
+        field[q]=tolower((unsigned char)field[q]);
+    if(field.substr(0,2)=="el" && field.length()==3)
+        field=field.substr(2);
+    if(field=="seq" && cond[p]=='%'){
+        q=cond.find("=", p);
+        if(q==string::npos)
+            return false;
+        fs.b=atoi(cond.substr(p+1, q-p-1).c_str());
+        fs.a=atoi(cond.substr(q+1).c_str());
+        return fs.b>0 && fs.a>=0 && fs.a<fs.b;
+    }
+    if(cond[p]=='%')
+        return false;
+    q=(p+1<cond.length() && cond[p+1]=='=') ? p+2 : p+1;
+    op=cond.substr(p, q-p);
+    value=settrim(cond.substr(q));
+    v=strtod(value.c_str(), &end);
+    if(value.length()==0 || *end!=0 || op=="==")
+        return false;
+    if(field=="seq" || field=="a"){
+        if(v!=v)
+            return false;
+        // bounds are clamped to int before converting, which is undefined past it
+        auto clampint=[](double x){ return (int)min(max(x, (double)numeric_limits<int>::min()), (double)numeric_limits<int>::max()); };
+        if(op=="=" || op==">=" || op==">")
+            fs.c=max(fs.c, clampint(ceil((op==">") ? floor(v)+1 : v)));
+        if(op=="=" || op=="<=" || op=="<")
+            fs.d=min(fs.d, clampint(floor((op=="<") ? ceil(v)-1 : v)));
+        return true;
+    }
+    if(field.length()!=1 || field[0]<'b' || field[0]>'t' || field[0]=='d')
+        return false;
+    col=field[0]-'b';
+    if(op=="=" || op==">=")
+        fs.lo[col]=max(fs.lo[col], v);
+    if(op=="=" || op=="<=")
+        fs.hi[col]=min(fs.hi[col], v);
+    if(op==">")
+        fs.lo[col]=max(fs.lo[col], nextafter(v, numeric_limits<double>::infinity()));
+    if(op=="<")
+        fs.hi[col]=min(fs.hi[col], nextafter(v, -numeric_limits<double>::infinity()));
+
+    return true;
+}
+
+// Routine to turn a batch query into a filter
+// range ("c:d") and mod ("a:b") come from the command line and may be empty.
+// The conditions of the query are separated by "and"; an empty query or "all"
+// passes every sequence.  Returns false with the offending text in bad if
+// something is not understood.
+bool parsequery(struct seqtable &st, string query, string range, string mod, struct filterspec &fs, string &bad){
+    string cond;
+    size_t p;
+
+    clearfilter(st, fs);
+    if(range.length()>0){
+        p=range.find(":");
+        if(p==string::npos){
+            bad=range;
+            return false;
+        }
+        fs.c=max(fs.c, atoi(range.substr(0, p).c_str()));
+        fs.d=min(fs.d, atoi(range.substr(p+1).c_str()));
+    }
+    if(mod.length()>0 && parsecondition("seq%"+settrim(mod.substr(mod.find(":")+1))+"="+mod.substr(0, mod.find(":")), fs)==false){
+        bad=mod;
+        return false;
+    }
+    query=settrim(query);
+    if(query.length()==0 || query=="all")
+        return true;
+    while(query.length()>0){
+        p=query.find(" and ");
+        cond=query.substr(0, p);
+        query=(p==string::npos) ? "" : query.substr(p+5);
+        if(parsecondition(cond, fs)==false){
+            bad=settrim(cond);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Routine to run the searches of batch mode
+// Each query is written as a "# query" line, then its matches in the given
+// format (one per line, or on one csv or tsv line), then a "# N sequences
+// found." line.  The binary format leaves out the text lines and writes each
+// query as an 8 byte count followed by 4 byte sequence numbers, little endian.
+// With countonly only "N<tab>query" is written.  Output goes to the file
+// output, or to stdout if output is empty.  All queries are read first and
+// then run together by runfilters().  Returns false if a query is not
+// understood or output cannot be written.
+bool runbatch(struct seqtable &st, const vector<string> &queries, string range, string mod, string output, int format, bool countonly, int nthreads){
+    struct resultwriter bout;
+    vector<struct filterspec> specs(queries.size());
+    vector<vector<uint32_t>> matches;
+    string bad;
+    uint64_t start, n;
+    size_t q, z;
+
+    for(q=0;q<queries.size();q++){
+        if(parsequery(st, queries[q], range, mod, specs[q], bad)==false){
+            cerr << "Query " << q+1 << ": cannot understand \"" << bad << "\"" << endl;
+            return false;
+        }
+    }
+    if(output.length()>0){
+        if(openwriterfile(bout, output, false, format)==false){
+            cerr << "Unable to write " << output << "!" << endl;
+            return false;
+        }
+    }
+    start=phasestart();
+    runfilters(st, specs, matches, nthreads);
+    for(q=0;q<queries.size();q++)
+        perf.matched+=matches[q].size();
+    phaseend(phasesearch, start);
+    start=phasestart();
+    if(output.length()==0)
+        openwriter(bout, STDOUT_FILENO, false, format);
+    for(q=0;q<queries.size();q++){
+        if(countonly==true){
+            writertext(bout, to_string(matches[q].size())+"\t"+queries[q]+"\n");
+            continue;
+        }
+        if(format==fmtbinary){
+            n=matches[q].size();
+            writerbytes(bout, &n, sizeof(n));
+        }
+        else
+            writertext(bout, "# "+queries[q]+"\n");
+        for(z=0;z<matches[q].size();z++)
+            writerid(bout, matches[q][z]);
+        writerendlist(bout);
+        if(format!=fmtbinary)
+            writertext(bout, "# "+to_string(matches[q].size())+" sequences found.\n");
+    }
+    phaseend(phaselisting, start);
+
+    return closewriter(bout);
+}
+
+// Routine to build everything a table otherwise fills in on first use
+// Afterwards searches only read the table, so any number of threads may run
+// them at once.  Column indexes not built by now are left unbuilt.
+void freezetable(struct seqtable &st){
+    dictfind(st, "");
+    cyclefind(st, "");
+    buildindex(st);
+    st.frozen=true;
+
+    return;
+}
+
+// structure for one connection to the daemon
+struct clientconn{
+    int fd;  // accepted socket, -1 once closed
+    string pending;  // bytes received after the last complete request line
+};
+
+// structure for the connections of the daemon
+// A connection is either idle, watched by the accepting thread for input, or
+// queued in fds for (or being served by) a worker, which hands it back
+// through back once its input is answered.
+struct clientqueue{
+    mutex lock;  // guards everything below
+    condition_variable ready;  // signalled when a connection is queued or stop is set
+    deque<struct clientconn *> fds;  // connections with input waiting for a worker
+    vector<struct clientconn *> back;  // served connections to be watched again
+    bool stop=false;  // the daemon is shutting down
+};
+
+// write end of the pipe that wakes the accepting thread of the daemon, and
+// whether SIGINT or SIGTERM asked it to stop
+static int serverwake=-1;
+static volatile sig_atomic_t serverstopping=0;
+
+// longest line the daemon takes as a request or the client takes as a reply
+const size_t maxline=65536;
+
+// Routine to append a list of sequences to a daemon reply, one per line
+void replylist(string &reply, const vector<uint32_t> &seqs){
+    char num[16], *p;
+    size_t z;
+
+    for(z=0;z<seqs.size();z++){
+        p=to_chars(num, num+sizeof(num), seqs[z]).ptr;
+        *p++='\n';
+        reply.append(num, p-num);
+    }
+
+    return;
+}
+
+// Routine to answer one request line sent to the daemon
+// The requests are
+//     seq N           the regina_file fields of sequence N
+//     prime P         sequences that terminate with the prime P
+//     merge N         sequences that merge with the open ended sequence N
+//     cycle N         sequences that end in the same cycle as sequence N
+//     query <conds>   sequences that pass the conditions of a batch query
+//     count <conds>   the number of sequences that pass a batch query
+// Every reply ends with a line holding a single ".", and a failed request is
+// answered with a line starting "error: ".
+string serverequest(struct seqtable &st, string req){
+    struct filterspec fs;
+    vector<uint32_t> seqlist;
+    const uint32_t *seqs;
+    string cmd, arg, bad, reply;
+    size_t k, nseqs, sp;
+    int64_t id;
+    int n;
+
+    req=settrim(req);
+    sp=req.find(" ");
+    cmd=req.substr(0, sp);
+    arg=(sp==string::npos) ? "" : settrim(req.substr(sp+1));
+    n=atoi(arg.c_str());
+    if((cmd=="seq" || cmd=="merge" || cmd=="cycle") && (n<2 || n>=st.seqscount))
+        return "error: sequence outside 2 through "+to_string(st.seqscount-1)+"\n.\n";
+    if(cmd=="seq")
+        reply=rowtext(st, n)+"\n";
+    else if(cmd=="prime"){
+        id=dictfind(st, arg);
+        nseqs=(id>=0) ? elDseqs(st, id, seqs) : 0;
+        for(k=0;k<nseqs;k++)
+            if(st.elB[seqs[k]]==1)
+                seqlist.push_back(seqs[k]);
+        replylist(reply, seqlist);
+    }
+    else if(cmd=="merge"){
+        if(st.elB[n]!=0 || dictvalue(st, st.elD[n])!=to_string(n))
+            return "error: "+to_string(n)+" is not the start of an open ended merge\n.\n";
+        nseqs=elDseqs(st, st.elD[n], seqs);
+        for(k=0;k<nseqs;k++)
+            if((int)seqs[k]>n)
+                seqlist.push_back(seqs[k]);
+        replylist(reply, seqlist);
+    }
+    else if(cmd=="cycle"){
+        if(st.elB[n]>=0)
+            return "error: "+to_string(n)+" does not end in a cycle\n.\n";
+        replylist(reply, cyclesequences(st, dictvalue(st, st.elD[n])));
+    }
+    else if(cmd=="query" || cmd=="count"){
+        if(parsequery(st, arg, "", "", fs, bad)==false)
+            return "error: cannot understand \""+bad+"\"\n.\n";
+        seqlist=runfilter(st, fs, 1);
+        if(cmd=="count")
+            reply=to_string(seqlist.size())+"\n";
+        else
+            replylist(reply, seqlist);
+    }
+    else
+        return "error: unknown request \""+cmd+"\"\n.\n";
+    reply.append(".\n");
+
+    return reply;
+}
+
+// Routine to send all of a reply down a socket
+bool sendall(int fd, const string &data){
+    size_t done=0;
+    ssize_t n;
+
+    while(done<data.length()){
+        n=send(fd, data.data()+done, data.length()-done, MSG_NOSIGNAL);
+        if(n<=0)
+            return false;
+        done+=n;
+    }
+
+    return true;
+}
+
+// Routine to serve the input waiting on one daemon connection
+// A single read is made, which does not block as poll() found input, and
+// every complete request line is answered.  Returns false once the client has
+// disconnected or sent a request line longer than maxline bytes, which is
+// answered with an error; the connection should then be closed.
+bool serveinput(struct seqtable &st, struct clientconn &c){
+    char buf[4096];
+    size_t eol;
+    ssize_t n;
+
+    n=read(c.fd, buf, sizeof(buf));
+    if(n<=0)
+        return false;
+    c.pending.append(buf, n);
+    while((eol=c.pending.find("\n"))!=string::npos){
+        if(sendall(c.fd, serverequest(st, c.pending.substr(0, eol)))==false)
+            return false;
+        c.pending.erase(0, eol+1);
+    }
+    if(c.pending.length()>maxline){
+        sendall(c.fd, "error: request longer than "+to_string(maxline)+" bytes\n.\n");
+        return false;
+    }
+
+    return true;
+}
+
+// Routine to ask the daemon to stop, on SIGINT or SIGTERM
+void serverstop(int){
+    int e=errno;
+
+    serverstopping=1;
+    if(serverwake>=0 && write(serverwake, "s", 1)<0){}
+    errno=e;
+
+    return;
+}
+
+// Routine to open a listening Unix socket at path, replacing a stale one
+// Anything at path other than a socket no server answers on is left alone,
+// and -1 is returned with a message.
+int listensocket(string path){
+    struct sockaddr_un addr;
+    struct stat sb;
+    int fd;
+
+    if(path.length()>=sizeof(addr.sun_path))
+        return -1;
+    fd=socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd<0)
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family=AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    if(lstat(path.c_str(), &sb)==0){
+        if(!S_ISSOCK(sb.st_mode)){
+            cerr << path << " exists and is not a socket!" << endl;
+            close(fd);
+            return -1;
+        }
+        if(connect(fd, (struct sockaddr *)&addr, sizeof(addr))==0){
+            cerr << "A server is already running on " << path << "!" << endl;
+            close(fd);
+            return -1;
+        }
+        unlink(path.c_str());
+    }
+    if(bind(fd, (struct sockaddr *)&addr, sizeof(addr))<0 || listen(fd, 64)<0){
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// Routine to run the daemon on the Unix socket path
+// The table is frozen and then served read-only.  The calling thread accepts
+// connections and polls the idle ones; a connection with input is handed to
+// one of nthreads workers, which answers the requests it has sent and hands
+// it back, so any number of clients can stay connected.  Runs until SIGINT or
+// SIGTERM, then closes every connection and removes the socket.
+bool runserver(struct seqtable &st, string path, int nthreads){
+    struct clientqueue cq;
+    struct sigaction sa, oldint, oldterm;
+    struct clientconn *c;
+    vector<thread> pool;
+    vector<struct pollfd> pfd;
+    vector<struct clientconn *> idle, still;
+    char drain[256];
+    size_t k;
+    int fd, lfd, i, wake[2];
+
+    freezetable(st);
+    lfd=listensocket(path);
+    if(lfd<0){
+        cerr << "Unable to listen on " << path << "!" << endl;
+        return false;
+    }
+    if(pipe2(wake, O_NONBLOCK|O_CLOEXEC)<0){
+        close(lfd);
+        unlink(path.c_str());
+        return false;
+    }
+    serverstopping=0;
+    serverwake=wake[1];
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler=serverstop;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &oldint);
+    sigaction(SIGTERM, &sa, &oldterm);
+    signal(SIGPIPE, SIG_IGN);
+    for(i=0;i<nthreads;i++){
+        pool.emplace_back([&st, &cq, &wake](){
+            struct clientconn *c;
+
+            while(true){
+                unique_lock<mutex> lk(cq.lock);
+                cq.ready.wait(lk, [&cq](){ return cq.stop==true || !cq.fds.empty(); });
+                if(cq.stop==true)
+                    return;
+                c=cq.fds.front();
+                cq.fds.pop_front();
+                lk.unlock();
+                if(serveinput(st, *c)==false){
+                    close(c->fd);
+                    c->fd=-1;
+                }
+                lk.lock();
+                cq.back.push_back(c);
+                lk.unlock();
+                if(write(wake[1], "w", 1)<0){}
+            }
+        });
+    }
+    cout << "Serving " << st.seqscount-2 << " sequences on " << path << endl;
+    while(serverstopping==0){
+        pfd.clear();
+        pfd.push_back({lfd, POLLIN, 0});
+        pfd.push_back({wake[0], POLLIN, 0});
+        for(k=0;k<idle.size();k++)
+            pfd.push_back({idle[k]->fd, POLLIN, 0});
+        if(poll(pfd.data(), pfd.size(), -1)<0){
+            if(errno==EINTR)
+                continue;
+            break;
+        }
+        while(read(wake[0], drain, sizeof(drain))>0);
+        still.clear();
+        {
+            lock_guard<mutex> lk(cq.lock);
+            // input or a hangup both go to a worker, whose read tells them apart
+            for(k=0;k<idle.size();k++){
+                if(pfd[k+2].revents!=0)
+                    cq.fds.push_back(idle[k]);
+                else
+                    still.push_back(idle[k]);
+            }
+            for(k=0;k<cq.back.size();k++){
+                if(cq.back[k]->fd<0)
+                    delete cq.back[k];
+                else
+                    still.push_back(cq.back[k]);
+            }
+            cq.back.clear();
+        }
+        idle.swap(still);
+        cq.ready.notify_all();
+        if((pfd[0].revents&POLLIN)!=0){
+            fd=accept4(lfd, NULL, NULL, SOCK_CLOEXEC);
+            if(fd>=0)
+                idle.push_back(new clientconn{fd, string()});
+        }
+    }
+
+    {
+        lock_guard<mutex> lk(cq.lock);
+        cq.stop=true;
+    }
+    cq.ready.notify_all();
+    for(i=0;i<(int)pool.size();i++)
+        pool[i].join();
+    idle.insert(idle.end(), cq.fds.begin(), cq.fds.end());
+    idle.insert(idle.end(), cq.back.begin(), cq.back.end());
+    for(k=0;k<idle.size();k++){
+        c=idle[k];
+        if(c->fd>=0)
+            close(c->fd);
+        delete c;
+    }
+    close(lfd);
+    unlink(path.c_str());
+    sigaction(SIGINT, &oldint, NULL);
+    sigaction(SIGTERM, &oldterm, NULL);
+    serverwake=-1;
+    close(wake[0]);
+    close(wake[1]);
+    cout << "Server on " << path << " stopped." << endl;
+
+    return true;
+}
+
+// Routine to send requests to a running daemon and print the replies
+// Each request is one line; with no requests given they are read from stdin.
+// Returns false if the daemon cannot be reached or a request fails.
+bool runclient(string path, vector<string> requests){
+    struct sockaddr_un addr;
+    string line, pending;
+    char buf[65536];
+    size_t eol, next=0;
+    ssize_t n;
+    int fd;
+    bool ok=true, readin=requests.empty(), done;
+
+    if(path.length()>=sizeof(addr.sun_path))
+        return false;
+    fd=socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family=AF_UNIX;
+    strcpy(addr.sun_path, path.c_str());
+    if(fd<0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr))<0){
+        cerr << "Unable to reach a server on " << path << "!" << endl;
+        if(fd>=0)
+            close(fd);
+        return false;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    while(true){
+        if(readin==true){
+            if(!getline(cin, line))
+                break;
+        }
+        else if(next<requests.size())
+            line=requests[next++];
+        else
+            break;
+        if(settrim(line).length()==0)
+            continue;
+        if(sendall(fd, line+"\n")==false){
+            ok=false;
+            break;
+        }
+        done=false;
+        while(done==false){
+            while(done==false && (eol=pending.find("\n"))!=string::npos){
+                if(pending.compare(0, eol, ".")==0)
+                    done=true;
+                else{
+                    if(pending.compare(0, 7, "error: ")==0)
+                        ok=false;
+                    cout.write(pending.data(), eol+1);
+                }
+                pending.erase(0, eol+1);
+            }
+            if(done==false){
+                if(pending.length()>maxline){
+                    cerr << "Reply line longer than " << maxline << " bytes!" << endl;
+                    close(fd);
+                    return false;
+                }
+                n=read(fd, buf, sizeof(buf));
+                if(n<=0){
+                    close(fd);
+                    return false;
+                }
+                pending.append(buf, n);
+            }
+        }
+    }
+    close(fd);
+    cout.flush();
+
+    return ok;
+}
+
+// bytes of the old file compared by one task of rundiff()
+const size_t diffchunk=16<<20;
+
+// names of the sequence endings counted by rundiff()
+const char *const endnames[]={"prime", "cycle", "open"};
+
+// structure for the differences found in one stretch of two regina_files
+struct diffpart{
+    string text;  // a line for each sequence that differs
+    uint64_t same;  // sequences whose fields all match
+    uint64_t changed;  // sequences in both files with a field that differs
+    uint64_t added;  // sequences only in the new file
+    uint64_t removed;  // sequences only in the old file
+    uint64_t cols[ncols];  // changed sequences by field, elB..elT
+    uint64_t moves[3][3];  // sequences by old and new ending (endnames order)
+};
+
+// Routine to read the sequence number (elA) at the start of a line
+// Returns -1 for a line that does not start with one.
+static inline int64_t lineseq(const char *p, const char *eol){
+    int64_t seq=-1;
+
+    while(p<eol && *p==' ')
+        p++;
+    from_chars(p, eol, seq);
+
+    return seq;
+}
+
+// Routine to find the first line that starts at or after p
+static inline const char *linestart(const char *data, const char *end, const char *p){
+    if(p<=data || p>=end || p[-1]=='\n')
+        return p;
+    p=(const char *)memchr(p, '\n', end-p);
+
+    return (p==NULL) ? end : p+1;
+}
+
+// Routine to find the first line of a regina_file whose sequence is seq or more
+// The lines are in sequence order, so this is a binary search over byte
+// offsets, only touching the pages it lands on.
+const char *seekseq(const char *data, const char *end, int64_t seq){
+    const char *lo=data, *hi=end, *mid, *l, *eol;
+
+    // Lines starting before lo are below seq and lines starting at hi or later are not
+    while(lo<hi){
+        mid=lo+(hi-lo)/2;
+        l=linestart(data, end, mid);
+        if(l>=hi){
+            hi=mid;
+            continue;
+        }
+        eol=(const char *)memchr(l, '\n', end-l);
+        if(lineseq(l, (eol==NULL) ? end : eol)<seq)
+            lo=l+1;
+        else
+            hi=l;
+    }
+
+    return linestart(data, end, lo);
+}
+
+// Routine to split a regina_file line into its fields, elA first
+// Returns the number of fields found; fields past the end of a short line are
+// left empty.
+int linefields(const char *p, const char *eol, string_view *f){
+    const char *comma;
+    int n=0, k;
+
+    while(n<=ncols){
+        comma=(const char *)memchr(p, ',', eol-p);
+        if(comma==NULL)
+            comma=eol;
+        f[n++]=string_view(p, comma-p);
+        if(comma==eol)
+            break;
+        p=comma+1;
+    }
+    for(k=n;k<=ncols;k++)
+        f[k]=string_view();
+
+    return n;
+}
+
+// Routine to tell whether field c (elB..elT) holds the same value in two lines
+// Numeric fields are compared by value as parseline() reads them, so a change
+// of formatting alone ("1.50" for "1.5") is not a difference.
+bool samefield(int c, string_view a, string_view b){
+    double x=0, y=0;
+    size_t p, q;
+
+    if(a==b)
+        return true;
+    if(c==colD)
+        return false;
+    for(p=0;p<a.size() && (a[p]==' ' || a[p]=='+');p++);
+    for(q=0;q<b.size() && (b[q]==' ' || b[q]=='+');q++);
+    from_chars(a.data()+p, a.data()+a.size(), x);
+    from_chars(b.data()+q, b.data()+b.size(), y);
+
+    return x==y;
+}
+
+// Routine to tell how a sequence ends from its elB field, as an endnames index
+int lineending(string_view elB){
+    int b=0;
+    size_t p;
+
+    for(p=0;p<elB.size() && (elB[p]==' ' || elB[p]=='+');p++);
+    from_chars(elB.data()+p, elB.data()+elB.size(), b);
+
+    return (b>0) ? 0 : ((b<0) ? 1 : 2);
+}
+
+// Routine to compare a stretch of an old regina_file with the matching stretch
+// of a new one
+// Both stretches are walked in sequence order together.  Identical lines are
+// passed over with one memcmp; other lines are split into fields and each
+// field that differs is listed as "elX old>new".
+void diffrange(const char *a, const char *aend, const char *b, const char *bend, struct diffpart &dp){
+    string_view fa[ncols+1], fb[ncols+1];
+    const char *ea, *eb, *ta, *tb;
+    int64_t sa, sb;
+    int c, from, to;
+    bool differs;
+
+    dp.text.clear();
+    dp.same=dp.changed=dp.added=dp.removed=0;
+    memset(dp.cols, 0, sizeof(dp.cols));
+    memset(dp.moves, 0, sizeof(dp.moves));
+    while(a<aend || b<bend){
+        ea=(a<aend) ? (const char *)memchr(a, '\n', aend-a) : NULL;
+        ea=(a<aend && ea==NULL) ? aend : ea;
+        eb=(b<bend) ? (const char *)memchr(b, '\n', bend-b) : NULL;
+        eb=(b<bend && eb==NULL) ? bend : eb;
+        sa=(a<aend) ? lineseq(a, ea) : INT64_MAX;
+        sb=(b<bend) ? lineseq(b, eb) : INT64_MAX;
+        // Lines without a sequence number (blank lines) are passed over
+        if(sa<0 || sb<0){
+            if(sa<0)
+                a=ea+1;
+            if(sb<0)
+                b=eb+1;
+            continue;
         }
-        else{
-            u=atoi(temp.c_str());
-            v=s;
+        if(sa<sb){
+            dp.text.append(to_string(sa)+"\tremoved\n");
+            dp.removed++;
+            a=ea+1;
+            continue;
         }
-    }
-    else{
-        u=0;
-        v=10000;
-    }
-    if(u<0)
-        u=0;
-    cout << "Range for smallest quotient of two consecutive terms (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            da=strtod(temp.substr(0,found).c_str(), &dp);
-            db=strtod(temp.substr(found+1).c_str(), &dp);
+        if(sb<sa){
+            dp.text.append(to_string(sb)+"\tadded\n");
+            dp.added++;
+            b=eb+1;
+            continue;
         }
-        else{
-            da=strtod(temp.c_str(), &dp);
-            db=da;
+        if(ea-a==eb-b && memcmp(a, b, ea-a)==0){
+            dp.same++;
+            a=ea+1;
+            b=eb+1;
+            continue;
         }
-    }
-    else{
-        da=0;
-        db=10000;
-    }
-    if(da<0)
-        da=0;
-    cout << "Range for largest quotient of two consecutive terms (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            dc=strtod(temp.substr(0,found).c_str(), &dp);
-            dd=strtod(temp.substr(found+1).c_str(), &dp);
+        ta=(ea>a && ea[-1]=='\r') ? ea-1 : ea;
+        tb=(eb>b && eb[-1]=='\r') ? eb-1 : eb;
+        linefields(a, ta, fa);
+        linefields(b, tb, fb);
+        differs=false;
+        for(c=0;c<ncols;c++){
+            if(samefield(c, fa[c+1], fb[c+1])==true)
+                continue;
+            if(differs==false)
+                dp.text.append(to_string(sa));
+            differs=true;
+            dp.cols[c]++;
+            dp.text.append("\tel");
+            dp.text.push_back('B'+c);
+            dp.text.push_back(' ');
+            dp.text.append(fa[c+1]);
+            dp.text.push_back('>');
+            dp.text.append(fb[c+1]);
         }
-        else{
-            dc=strtod(temp.c_str(), &dp);
-            dd=dc;
+        if(differs==true){
+            dp.text.push_back('\n');
+            dp.changed++;
+            from=lineending(fa[1]);
+            to=lineending(fb[1]);
+            if(from!=to)
+                dp.moves[from][to]++;
         }
+        else
+            dp.same++;
+        a=ea+1;
+        b=eb+1;
     }
-    else{
-        dc=0;
-        dd=10000;
+
+    return;
+}
+
+// Routine to hand the pages of a mapped file between from and to back to the system
+void dropmapped(const struct filemap &fm, const char *from, const char *to){
+    uintptr_t lo, hi;
+
+    if(fm.mapped==false)
+        return;
+    lo=((uintptr_t)from+4095)&~(uintptr_t)4095;
+    hi=(uintptr_t)to&~(uintptr_t)4095;
+    if(lo<hi)
+        madvise((void *)lo, hi-lo, MADV_DONTNEED);
+
+    return;
+}
+
+// Routine to list the differences between two revisions of regina_file
+// Nothing is loaded into a table.  The old file is cut into diffchunk
+// stretches at line starts, the matching place in the new file is found by
+// sequence number, and the stretch pairs are compared on all cores.  Stretches
+// are taken nthreads at a time and their pages dropped once written, so memory
+// use stays bounded however large the files are.  One line is written for each
+// sequence that differs, followed by a summary of the counts per field and the
+// sequences whose ending changed.
+bool rundiff(string oldname, string newname, string output, int nthreads){
+    struct filemap fo, fn;
+    struct diffpart total;
+    vector<struct diffpart> parts;
+    vector<const char *> acut, bcut;
+    const char *aend, *bend, *p, *eol;
+    ofstream fout;
+    size_t pos, first, k, n;
+    int c, i, j;
+
+    if(isarchive(oldname) || isarchive(newname)){
+        cerr << "--diff needs unpacked files!" << endl;
+        return false;
     }
-    if(dc<0)
-        dc=0;
-    cout << "Range for arith mean of all quotients of 2 consequtive terms (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            de=strtod(temp.substr(0,found).c_str(), &dp);
-            df=strtod(temp.substr(found+1).c_str(), &dp);
-        }
-        else{
-            de=strtod(temp.c_str(), &dp);
-            df=de;
-        }
+    if(openmap(oldname, fo)==false){
+        cerr << "Unable to read " << oldname << "!" << endl;
+        return false;
     }
-    else{
-        de=0;
-        df=10000;
+    if(openmap(newname, fn)==false){
+        cerr << "Unable to read " << newname << "!" << endl;
+        closemap(fo);
+        return false;
     }
-    if(de<0)
-        de=0;
-    cout << "Range for geo mean of all quotients of 2 consequtive terms (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            dg=strtod(temp.substr(0,found).c_str(), &dp);
-            dh=strtod(temp.substr(found+1).c_str(), &dp);
-        }
-        else{
-            dg=strtod(temp.c_str(), &dp);
-            dh=dg;
+    if(output.length()>0){
+        fout.open(output);
+        if(!fout.is_open()){
+            cerr << "Unable to write " << output << "!" << endl;
+            closemap(fo);
+            closemap(fn);
+            return false;
         }
     }
-    else{
-        dg=0;
-        dh=10000;
+    ostream &dout=(fout.is_open()) ? fout : cout;
+    perf.bytesread+=fo.size+fn.size;
+    cerr << "Comparing " << oldname << " with " << newname << " . . ." << endl;
+
+    aend=fo.data+fo.size;
+    bend=fn.data+fn.size;
+    acut.push_back(fo.data);
+    bcut.push_back(fn.data);
+    for(pos=diffchunk;pos<fo.size;pos+=diffchunk){
+        p=linestart(fo.data, aend, fo.data+pos);
+        if(p>=aend)
+            break;
+        if(p==acut.back())
+            continue;
+        eol=(const char *)memchr(p, '\n', aend-p);
+        acut.push_back(p);
+        bcut.push_back(max(bcut.back(), seekseq(fn.data, bend, lineseq(p, (eol==NULL) ? aend : eol))));
+        // Each search leaves pages all over the new file mapped
+        dropmapped(fn, fn.data, bend);
     }
-    if(dg<0)
-        dg=0;
-    cout << "Range for arith mean of # of digits of all the mins (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            di=strtod(temp.substr(0,found).c_str(), &dp);
-            dj=strtod(temp.substr(found+1).c_str(), &dp);
-        }
-        else{
-            di=strtod(temp.c_str(), &dp);
-            dj=di;
+    acut.push_back(aend);
+    bcut.push_back(bend);
+    dropmapped(fo, fo.data, aend);
+
+    total=diffpart();
+    n=acut.size()-1;
+    for(first=0;first<n;first+=nthreads){
+        parts=vector<struct diffpart>(min((size_t)nthreads, n-first));
+        parallelfor(nthreads, parts.size(), [&](int t, int){
+            diffrange(acut[first+t], acut[first+t+1], bcut[first+t], bcut[first+t+1], parts[t]);
+        });
+        for(k=0;k<parts.size();k++){
+            dout.write(parts[k].text.data(), parts[k].text.size());
+            total.same+=parts[k].same;
+            total.changed+=parts[k].changed;
+            total.added+=parts[k].added;
+            total.removed+=parts[k].removed;
+            for(c=0;c<ncols;c++)
+                total.cols[c]+=parts[k].cols[c];
+            for(i=0;i<3;i++)
+                for(j=0;j<3;j++)
+                    total.moves[i][j]+=parts[k].moves[i][j];
         }
+        dropmapped(fo, acut[first], acut[first+parts.size()]);
+        dropmapped(fn, bcut[first], bcut[first+parts.size()]);
     }
-    else{
-        di=0;
-        dj=10000;
+
+    dout << "# " << total.same+total.changed << " sequences in both files: " << total.same << " the same, " << total.changed << " changed\n";
+    dout << "# " << total.added << " sequences added, " << total.removed << " removed\n";
+    for(c=0;c<ncols;c++)
+        if(total.cols[c]>0)
+            dout << "# el" << (char)('B'+c) << " changed in " << total.cols[c] << " sequences\n";
+    for(i=0;i<3;i++)
+        for(j=0;j<3;j++)
+            if(total.moves[i][j]>0)
+                dout << "# " << total.moves[i][j] << " sequences went from " << endnames[i] << " to " << endnames[j] << "\n";
+    dout.flush();
+    closemap(fo);
+    closemap(fn);
+
+    return !dout.fail();
+}
+
+// seed of --gen-synthetic, so every run writes the same file
+const uint64_t synthseed=20210511;
+
+// number of runs of each benchmark of --bench
+const int benchreps=5;
+
+// number of values looked up by the prime and merge benchmarks
+const int benchlookups=1000;
+
+// searches run by the filter benchmark of --bench
+const char *const benchqueries[]={
+    "elB=0 and elC>=500",
+    "elB=1 and elR<1.01",
+    "elC>2000",
+    "elB<0 and seq%7=3",
+    "elF>=50 and elE<100",
+    "elO<0.02 and elP>70 and elQ>=2"
+};
+
+// searches that --bench runs both as planned and as a forced scan, chosen so
+// the NaN rows of a synthetic file meet the index, stride, zone skip and scan
+const char *const planqueries[]={
+    "elO<0.0102",
+    "elO<0.01",
+    "elO<0.9",
+    "elB=0 and seq%997=5 and elO<0.9",
+    "seq%1000=0 and elO>0.5",
+    "elO>=0.5 and elP<5"
+};
+
+// Routine to step the random number generator of --gen-synthetic (splitmix64)
+// Only integer arithmetic is used, so the same seed gives the same file with
+// any compiler or library.
+static inline uint64_t synthrand(uint64_t &state){
+    uint64_t z=(state+=0x9E3779B97F4A7C15ULL);
+
+    z=(z^(z>>30))*0xBF58476D1CE4E5B9ULL;
+    z=(z^(z>>27))*0x94D049BB133111EBULL;
+
+    return z^(z>>31);
+}
+
+// Routine to draw a whole number from lo through hi
+static inline uint64_t synthrange(uint64_t &state, uint64_t lo, uint64_t hi){
+    return lo+synthrand(state)%(hi-lo+1);
+}
+
+// Routine to write a number of units as a decimal with the given places
+static inline char *synthfixed(char *p, uint64_t units, int places){
+    uint64_t scale=1;
+    int k;
+
+    for(k=0;k<places;k++)
+        scale*=10;
+    p=to_chars(p, p+24, units/scale).ptr;
+    *p++='.';
+    units%=scale;
+    for(k=places-1;k>=0;k--){
+        p[k]='0'+units%10;
+        units/=10;
     }
-    if(di<0)
-        di=0;
-    cout << "Range for arith mean of # of digits of all the maxes (min max): ";
-    getline(cin, temp);
-    if(temp.length()>0){
-        found=temp.find(" ");
-        if(found!=string::npos){
-            dk=strtod(temp.substr(0,found).c_str(), &dp);
-            dl=strtod(temp.substr(found+1).c_str(), &dp);
+
+    return p+places;
+}
+
+// Routine to write a synthetic regina_file of rows sequences starting at 2
+// The endings follow the real file: about 84% end with a prime, mostly small
+// ones such as 43 and 59 with a tail of large ones, 13% are open and mostly
+// merge with one of the low open ended sequences (276, 552, ..., which are
+// always written as open ended themselves), and 3% end in one of the
+// known perfect, amicable or sociable cycles (so the cycle catalog can be
+// worked out from them).  The other fields are drawn uniformly over their
+// usual ranges, except that every 1000th sequence has nan for elO so the
+// searches meet NaN values.
+bool gensynthetic(string name, int64_t rows, uint64_t seed){
+    static const char *const primes[]={"43", "59", "41", "37", "7", "11", "13", "19", "23", "31", "47", "53", "61", "67", "71", "73", "79", "83", "89", "97", "101", "103", "107", "109", "113"};
+    static const char *const bigprimes[]={"1000003", "1000033", "99999989", "2147483647", "1000000000039", "18446744073709551557", "12345678901234567891"};
+    static const char *const cycles[][5]={{"6"}, {"28"}, {"496"}, {"8128"}, {"220", "284"}, {"1184", "1210"}, {"2620", "2924"}, {"12496", "14288", "15472", "14536", "14264"}, {"1264460", "1547860", "1727636", "1305184"}};
+    static const int cyclelen[]={1, 1, 1, 1, 2, 2, 2, 5, 4};
+    static const int roots[]={276, 552, 564, 660, 966, 1074, 1134, 1464, 1476, 1488};
+    // ranges of elO..elT in units of their last decimal place
+    static const uint64_t dlo[]={10000000, 1000000000, 500000000, 800000000, 1000000, 1000000};
+    static const uint64_t dhi[]={1000000000, 80000000000, 2500000000, 1200000000, 40000000, 50000000};
+    static const int dplaces[]={9, 9, 9, 9, 6, 6};
+    vector<char> buf(1<<20);
+    char *p, *flush=buf.data()+buf.size()-512;
+    uint64_t state=seed, r;
+    int64_t a;
+    int b, c, k, nroots;
+    bool root;
+    FILE *fp;
+
+    fp=fopen(name.c_str(), "w");
+    if(fp==NULL)
+        return false;
+    p=buf.data();
+    for(a=2;a<rows+2;a++){
+        p=to_chars(p, p+24, a).ptr;
+        *p++=',';
+        r=synthrange(state, 0, 999);
+        root=(find(roots, roots+10, a)!=roots+10);
+        if(root==true)
+            r=900;
+        if(r<840){
+            p=to_chars(p, p+24, 1).ptr;
+            *p++=',';
+            p=to_chars(p, p+24, synthrange(state, 1, 3000)).ptr;
+            *p++=',';
+            r=synthrange(state, 0, 99);
+            if(r<90)
+                p=stpcpy(p, primes[synthrange(state, 0, 24)]);
+            else if(r<95)
+                p=stpcpy(p, bigprimes[synthrange(state, 0, 6)]);
+            else
+                p=to_chars(p, p+24, synthrange(state, 500000, 499999999)*2+1).ptr;
+        }
+        else if(r<970){
+            p=to_chars(p, p+24, 0).ptr;
+            *p++=',';
+            // Open ended sequences run long, a few of them very long
+            p=to_chars(p, p+24, (synthrange(state, 0, 99)==0) ? synthrange(state, 3000, 12000) : synthrange(state, 1, 3000)).ptr;
+            *p++=',';
+            for(nroots=0;nroots<10 && roots[nroots]<a;nroots++);
+            if(root==false && nroots>0 && synthrange(state, 0, 99)<95)
+                p=to_chars(p, p+24, roots[synthrange(state, 0, nroots-1)]).ptr;
+            else
+                p=to_chars(p, p+24, a).ptr;
         }
         else{
-            dk=strtod(temp.c_str(), &dp);
-            dl=dk;
+            c=synthrange(state, 0, 8);
+            b=-cyclelen[c];
+            p=to_chars(p, p+24, b).ptr;
+            *p++=',';
+            p=to_chars(p, p+24, synthrange(state, 1, 3000)).ptr;
+            *p++=',';
+            p=stpcpy(p, cycles[c][synthrange(state, 0, cyclelen[c]-1)]);
+        }
+        *p++=',';
+        // elE, elF, then elG..elN
+        p=to_chars(p, p+24, synthrange(state, 1, 5000)).ptr;
+        *p++=',';
+        p=to_chars(p, p+24, synthrange(state, 1, 60)).ptr;
+        *p++=',';
+        for(k=0;k<8;k++){
+            p=to_chars(p, p+24, synthrange(state, 0, 400)).ptr;
+            *p++=',';
+        }
+        for(k=0;k<6;k++){
+            r=synthrange(state, dlo[k], dhi[k]);
+            p=(k==0 && a%1000==0) ? stpcpy(p, "nan") : synthfixed(p, r, dplaces[k]);
+            *p++=',';
+        }
+        *p++='\n';
+        if(p>=flush){
+            fwrite(buf.data(), 1, p-buf.data(), fp);
+            p=buf.data();
         }
     }
-    else{
-        dk=0;
-        dl=10000;
+    fwrite(buf.data(), 1, p-buf.data(), fp);
+    if(ferror(fp)){
+        fclose(fp);
+        return false;
     }
-    if(dk<0)
-        dk=0;
 
-    cout << "List filtered sequences for " << a << " (mod " << b << ") from " << c << " through " << d << "? (y/n/c/f): ";
-    getline(cin, yn);
-    if(yn.substr(0,1)=="n")
-        return;
-    if(yn.substr(0,1)=="y" || yn.substr(0,1)=="f" || yn.substr(0,1)=="c"){
-        if(yn.substr(0,1)=="f"){
-            aout.open("results.txt", std::ios_base::app);
-            aout << "All filtered sequences for " << a << " (mod " << b << ") from " << c << " through " << d << ":" << endl;
+    return fclose(fp)==0;
+}
+
+// Routine to time benchreps runs of one benchmark and print its result line
+// The line is tab separated: name, best and median time in ms, the number of
+// items handled per run and a check value worked out from what was found.  The
+// check value must not change between builds, so results from two commits can
+// be compared line by line.
+void benchmark(string name, uint64_t items, const function<uint64_t()> &work){
+    vector<double> ms;
+    uint64_t check=0;
+    char line[256];
+    int k;
+
+    for(k=0;k<benchreps;k++){
+        auto start=chrono::steady_clock::now();
+        check=work();
+        ms.push_back(chrono::duration<double, milli>(chrono::steady_clock::now()-start).count());
+    }
+    sort(ms.begin(), ms.end());
+    snprintf(line, sizeof(line), "%s\t%.3f\t%.3f\t%llu\t%llu\n", name.c_str(), ms[0], ms[ms.size()/2], (unsigned long long)items, (unsigned long long)check);
+    cout << line;
+    cout.flush();
+
+    return;
+}
+
+// Routine to run the benchmarks of --bench on infile
+// Each benchmark does the work of one REPL command without its console
+// output: load parses the file (no snapshot), prime looks up benchlookups
+// terminal primes as p## does, merge lists the merges of benchlookups open
+// ended sequences, filter runs benchqueries through the advanced search engine
+// and census counts the sequences ending with each prime.  The first lines
+// give the file, threads and instruction set, so only like runs are compared;
+// the check value of load is the number of rows.  Before timing the searches,
+// each of planqueries is run as planned and as a forced scan, and the bench
+// stops if the two ever differ.
+bool runbench(string infile, int nthreads){
+    struct seqtable st=seqtable();
+    struct stat sb;
+    struct filterspec fs;
+    vector<struct filterspec> specs;
+    vector<string> primes;
+    vector<uint32_t> roots;
+    vector<int> plcount;
+    vector<uint32_t> plist;
+    string bad;
+    size_t q;
+    uint32_t id;
+    int i, step;
+    bool archive=isarchive(infile), ok=true;
+
+    cerr << "Benchmarking with " << infile << " . . ." << endl;
+    if(stat(infile.c_str(), &sb)!=0){
+        cerr << "Unable to read " << infile << "!" << endl;
+        return false;
+    }
+    cout << "# file\t" << infile << "\n";
+    cout << "# threads\t" << nthreads << "\n";
+    cout << "# simd\t" << kernels.name << "\n";
+    cout << "# reps\t" << benchreps << "\n";
+    cout << "# name\tbest_ms\tmedian_ms\titems\tcheck\n";
+    benchmark("load", sb.st_size, [&]()->uint64_t{
+        freetable(st);
+        ok=(archive==true) ? loadarchive(infile, st, nthreads) : loadregina(infile, st, nthreads);
+        return (ok==true) ? st.seqscount-2 : 0;
+    });
+    if(ok==false){
+        cerr << "Error reading " << infile << "!!" << endl;
+        return false;
+    }
+
+    // Sample the terminal primes and merge roots evenly through the file
+    for(i=2;i<st.seqscount;i++){
+        if(st.elB[i]==1)
+            primes.push_back(string(dictvalue(st, st.elD[i])));
+        else if(st.elB[i]==0 && dictvalue(st, st.elD[i])==to_string(i))
+            roots.push_back(i);
+    }
+    sort(primes.begin(), primes.end());
+    primes.erase(unique(primes.begin(), primes.end()), primes.end());
+    step=primes.size()/benchlookups+1;
+    for(q=0,i=0;i<(int)primes.size();i+=step)
+        primes[q++]=primes[i];
+    primes.resize(q);
+    step=roots.size()/benchlookups+1;
+    for(q=0,i=0;i<(int)roots.size();i+=step)
+        roots[q++]=roots[i];
+    roots.resize(q);
+
+    benchmark("prime", primes.size(), [&]()->uint64_t{
+        const uint32_t *seqs;
+        vector<uint32_t> listed;
+        uint64_t found=0;
+        size_t k, m, nseqs;
+        int64_t pid;
+
+        for(k=0;k<primes.size();k++){
+            pid=dictfind(st, primes[k]);
+            nseqs=(pid>=0) ? elDseqs(st, pid, seqs) : 0;
+            listed.clear();
+            for(m=0;m<nseqs;m++)
+                if(st.elB[seqs[m]]==1)
+                    listed.push_back(seqs[m]);
+            found+=setfromlist(listed).count;
         }
+        return found;
+    });
+    benchmark("merge", roots.size(), [&]()->uint64_t{
+        const uint32_t *seqs;
+        vector<uint32_t> listed;
+        uint64_t found=0;
+        size_t k, m, nseqs;
+
+        for(k=0;k<roots.size();k++){
+            nseqs=elDseqs(st, st.elD[roots[k]], seqs);
+            listed.clear();
+            for(m=0;m<nseqs;m++)
+                if(seqs[m]>roots[k])
+                    listed.push_back(seqs[m]);
+            found+=setfromlist(listed).count;
+        }
+        return found;
+    });
+    for(q=0;q<sizeof(benchqueries)/sizeof(benchqueries[0]);q++){
+        if(parsequery(st, benchqueries[q], "", "", fs, bad)==false){
+            cerr << "Benchmark query cannot be understood: " << bad << endl;
+            return false;
+        }
+        specs.push_back(fs);
     }
-    rcount=0;
-    crlf=false;
-    for(i=c;i<=d;i++){
-        show=true;
-        if(a!=i%b){
-            show=false;
-        }
-        if(show==true && uselist==true && seqd[i].ulist==false)
-            show=false;
-        if(show==true && e==-1 && seqd[i].elB>-1)
-            show=false;
-        if(show==true && e!=seqd[i].elB && e!=2)
-            show=false;
-        if(show==true && (seqd[i].elC<w || seqd[i].elC>x))
-            show=false;
-        if(show==true && (seqd[i].elG<f || seqd[i].elG>g))
-            show=false;
-        if(show==true && (seqd[i].elH<h || seqd[i].elH>j))
-            show=false;
-        if(show==true && (seqd[i].elI<k || seqd[i].elI>l))
-            show=false;
-        if(show==true && (seqd[i].elJ<m || seqd[i].elJ>n))
-            show=false;
-        if(show==true && (seqd[i].elK<o || seqd[i].elK>p))
-            show=false;
-        if(show==true && (seqd[i].elL<q || seqd[i].elL>r))
-            show=false;
-        if(show==true && (seqd[i].elM<s || seqd[i].elM>t))
-            show=false;
-        if(show==true && (seqd[i].elN<u || seqd[i].elN>v))
-            show=false;
-        if(show==true && (seqdd[i].elO<da || seqdd[i].elO>db))
-            show=false;
-        if(show==true && (seqdd[i].elP<dc || seqdd[i].elP>dd))
-            show=false;
-        if(show==true && (seqdd[i].elQ<de || seqdd[i].elQ>df))
-            show=false;
-        if(show==true && (seqdd[i].elR<dg || seqdd[i].elR>dh))
-            show=false;
-        if(show==true && (seqdd[i].elS<di || seqdd[i].elS>dj))
-            show=false;
-        if(show==true && (seqdd[i].elT<dk || seqdd[i].elT>dl))
-            show=false;
-        if(show==true){
-            if(aout.is_open())
-                aout << i << endl;
-            temp.assign(to_string(i));
-            temp.append("          ");
-            temp=temp.substr(0,10);
-            if(yn.substr(0,1)!="c")
-                cout << temp;
-            rcount++;
-            crlf=true;
+    for(q=0;q<sizeof(planqueries)/sizeof(planqueries[0]);q++){
+        struct filterplan fp;
+        vector<uint32_t> planned;
+
+        if(parsequery(st, planqueries[q], "", "", fs, bad)==false){
+            cerr << "Benchmark query cannot be understood: " << bad << endl;
+            return false;
+        }
+        fp=planfilter(st, fs);
+        planned=runplan(st, fs, fp, nthreads);
+        if(fp.how!=plannone)
+            fp.how=planscan;
+        if(runplan(st, fs, fp, nthreads)!=planned){
+            cerr << "Planned search and scan disagree on " << planqueries[q] << "!" << endl;
+            return false;
         }
     }
-    if(aout.is_open())
-        aout.close();
-    if(crlf==true && yn.substr(0,1)!="c")
-        cout << endl;
-    if(rcount!=1)
-        cout << rcount << " sequences found." << endl;
-    else
-        cout << rcount << " sequence found." << endl;
+    benchmark("filter", (uint64_t)(st.seqscount-2)*specs.size(), [&]()->uint64_t{
+        uint64_t found=0;
 
-    return;
+        for(q=0;q<specs.size();q++)
+            found+=runfilter(st, specs[q], nthreads).size();
+        return found;
+    });
+    benchmark("census", st.seqscount-2, [&]()->uint64_t{
+        uint64_t found=0;
 
+        primecensus(st, nthreads, plist, plcount);
+        for(id=0;id<plist.size();id++)
+            found+=plcount[plist[id]];
+        return plist.size()*1000000007ULL+found;
+    });
+    freetable(st);
+
+    return true;
 }
 
-// This routine finds all sequences that terminate with the supplied prime
-void primesfind(struct seqdata seqd[], struct seqdatad seqdd[], int seqscount, int seqn){
-    string yn, temp;
+int main(int argv, char *argc[])
+{
+    ifstream in;
     ofstream out;
-    int j, rcount;
-    bool uselist;
+    struct resultwriter fout, screen;
+    struct seqtable st;
+    string buff, infile, seqq, sequence, simd, temp, yn;
+    string diffnew, diffold, modopt, output, rangeopt, serve;
+    vector<string> queries;
+    vector<string_view> cycles;
+    string_view dval;
+    int64_t pid;
+    vector<uint32_t> cycleseqs, listed;
+    const uint32_t *seqs;
+    map<string, struct seqset> sets;
+    struct seqset last=seqset(), prev;
+    const struct seqset *input;
+    size_t m, nseqs;
+    uint64_t start;
+    int format=fmtlines, i, j, nthreads, rcount, seqn, updated;
+    size_t found;
+    bool archive, bench=false, countonly=false, fresh, none;
 
-    cout << "List all sequences that terminate with " << seqd[seqn].elD << "? (y/n/c/f): ";
-    getline(cin, yn);
-    if(yn.substr(0,1)=="y" || yn.substr(0,1)=="f" || yn.substr(0,1)=="c"){
-        if(yn.substr(0,1)=="f"){
-            out.open("results.txt", std::ios_base::app);
-            out << "All sequences that terminate with " << seqd[seqn].elD << ":" << endl;
+    infile.assign("regina_file");
+    nthreads=thread::hardware_concurrency();
+    for(i=1;i<argv;i++){
+        temp.assign(argc[i]);
+        if(temp=="--threads" && i+1<argv)
+            nthreads=atoi(argc[++i]);
+        else if(temp.substr(0,10)=="--threads=")
+            nthreads=atoi(temp.substr(10).c_str());
+        else if(temp=="--simd" && i+1<argv)
+            simd.assign(argc[++i]);
+        else if(temp.substr(0,7)=="--simd=")
+            simd.assign(temp.substr(7));
+        else if(temp=="--query" && i+1<argv)
+            queries.push_back(argc[++i]);
+        else if(temp.substr(0,8)=="--query=")
+            queries.push_back(temp.substr(8));
+        else if((temp=="--queries" && i+1<argv) || temp.substr(0,10)=="--queries="){
+            buff.assign((temp=="--queries") ? argc[++i] : temp.substr(10));
+            in.open(buff);
+            if(!in.is_open()){
+                cerr << "Unable to read " << buff << "!" << endl;
+                return 1;
+            }
+            while(getline(in, buff)){
+                buff=settrim(buff);
+                if(buff.length()>0 && buff[0]!='#')
+                    queries.push_back(buff);
+            }
+            in.close();
         }
-        rcount=0;
-        for(j=2;j<seqscount;j++){
-            if(seqd[j].elD==seqd[seqn].elD){
-                if(out.is_open())
-                    out << j << endl;
-                temp.assign(to_string(j));
-                temp.append("          ");
-                temp=temp.substr(0,10);
-                if(yn!="c")
-                    cout << temp;
-                seqd[j].ulist=true;
-                rcount++;
+        else if(temp=="--range" && i+1<argv)
+            rangeopt.assign(argc[++i]);
+        else if(temp.substr(0,8)=="--range=")
+            rangeopt.assign(temp.substr(8));
+        else if(temp=="--mod" && i+1<argv)
+            modopt.assign(argc[++i]);
+        else if(temp.substr(0,6)=="--mod=")
+            modopt.assign(temp.substr(6));
+        else if(temp=="--output" && i+1<argv)
+            output.assign(argc[++i]);
+        else if(temp.substr(0,9)=="--output=")
+            output.assign(temp.substr(9));
+        else if(temp=="--count")
+            countonly=true;
+        else if((temp=="--format" && i+1<argv) || temp.substr(0,9)=="--format="){
+            buff.assign((temp=="--format") ? argc[++i] : temp.substr(9));
+            for(format=fmtlines;format<=fmtbinary && buff!=fmtnames[format];format++);
+            if(format>fmtbinary){
+                cerr << "Unknown format " << buff << "; use lines, csv, tsv or binary." << endl;
+                return 1;
             }
-            else
-                seqd[j].ulist=false;
         }
-        if(out.is_open())
-            out.close();
-        if(yn!="c")
-            cout << endl;
-        if(rcount>1){
-            cout << rcount << " sequences found." << endl;
-            cout << "Perform Advanced Filtering on these results? (y/n): ";
-            getline(cin, yn);
-            if(yn.substr(0,1)=="y"){
-                uselist=true;
-                advanced(seqd, seqdd, seqscount, uselist);
+        else if(temp=="--bench")
+            bench=true;
+        else if(temp=="--stats" || temp=="--stats=text")
+            atexit(statstext);
+        else if(temp=="--stats=json")
+            atexit(statsjson);
+        else if(temp=="--gen-synthetic" && i+2<argv){
+            buff.assign(argc[i+2]);
+            if(atoll(argc[i+1])<1 || gensynthetic(buff, atoll(argc[i+1]), synthseed)==false){
+                cerr << "Unable to write " << buff << "!" << endl;
+                return 1;
+            }
+            cerr << atoll(argc[i+1]) << " synthetic sequences written to " << buff << endl;
+            return 0;
+        }
+        else if(temp=="--diff" && i+2<argv){
+            diffold.assign(argc[++i]);
+            diffnew.assign(argc[++i]);
+        }
+        else if(temp=="--serve" && i+1<argv)
+            serve.assign(argc[++i]);
+        else if(temp.substr(0,8)=="--serve=")
+            serve.assign(temp.substr(8));
+        else if(temp=="--client" && i+1<argv){
+            buff.assign(argc[++i]);
+            temp.clear();
+            for(i++;i<argv;i++){
+                temp.append(argc[i]);
+                temp.append((i+1<argv) ? " " : "");
             }
+            return (runclient(buff, (temp.length()>0) ? vector<string>{temp} : vector<string>())==true) ? 0 : 1;
         }
         else
-            cout << rcount << " sequence found." << endl;
+            infile.assign(temp);
     }
-    return;
-}
-
-int main(int argv, char *argc[])
-{
-    ifstream in, cyc;
-    ofstream out;
-    static struct seqdata seqd[20000001];
-    static struct seqdatad seqdd[20000001];
-    string buff, cycles[40], infile, seqq, sequence, temp, yn;
-    char *p;
-    int c, i, j, k, ccount=0, ocount=0, pcount=0, rcount, seqn, seqscount=2;
-    size_t found, founde, foundp;
-    bool none, uselist;
-
-    if(argv>1)
-        infile.assign(argc[1]);
-    else
-        infile.assign("regina_file");
+    if(nthreads<1)
+        nthreads=1;
+    selectkernels(simd);
+    if(diffold.length()>0)
+        return (rundiff(diffold, diffnew, output, nthreads)==true) ? 0 : 1;
+    if(bench==true)
+        return (runbench(infile, nthreads)==true) ? 0 : 1;
+    // Batch mode keeps stdout for results, so progress goes to stderr
+    ostream &info=(queries.empty()) ? cout : cerr;
 
-    cout << "Reading " << infile << " . . .";
-    fflush(stdout);
+    // Without an unpacked regina_file, read the archive it comes in
+    if(infile=="regina_file" && access(infile.c_str(), F_OK)!=0 && access("regina_file.tar.lzma", F_OK)==0)
+        infile.assign("regina_file.tar.lzma");
+    archive=isarchive(infile);
+    info << "Reading " << infile << " . . .";
+    info.flush();
 
-    in.open(infile);
+    if(archive==false)
+        in.open(infile);
     if(in.is_open()){
         getline(in, buff);
         in.close();
         found=buff.find("[");
         if(found!=string::npos){
-            cout << "\rThis program does not work with the original regina_file!" << endl;
-            cout << "Please use the new one. An alternate filename can be added" << endl;
-            cout << "to the command line to call it instead of regina_file." << endl;
-            return 0;
+            info << "\rThis program does not work with the original regina_file!" << endl;
+            info << "Please use the new one. An alternate filename can be added" << endl;
+            info << "to the command line to call it instead of regina_file." << endl;
+            return (queries.empty()) ? 0 : 1;
         }
     }
 
-    in.open(infile);
-    if(in.is_open()){
-        while(!in.eof() && seqscount<20000001){
-            getline(in, buff);
-            // elA not used
-            found=buff.find(",");
-            if(found!=string::npos)
-                buff.assign(buff.substr(found+1));
-            // Assign elB
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elB);
-                buff.assign(buff.substr(found+1));
-                if(seqd[seqscount].elB>0)
-                    pcount++;
-                if(seqd[seqscount].elB==0)
-                    ocount++;
-                if(seqd[seqscount].elB<0)
-                    ccount++;
-            }
-            // Assign elC
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elC);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elD
-            found=buff.find(",");
-            if(found!=string::npos){
-                seqd[seqscount].elD.assign(buff.substr(0,found));
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elE
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elE);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elF
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elF);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elG
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elG);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elH
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elH);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elI
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elI);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elJ
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elJ);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elK
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elK);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elL
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elL);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elM
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elM);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elN
-            found=buff.find(",");
-            if(found!=string::npos){
-                sscanf(buff.substr(0,found).c_str(), "%d", &seqd[seqscount].elN);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elO
-            found=buff.find(",");
-            if(found!=string::npos){
-                seqdd[seqscount].elO=strtod(buff.substr(0,found).c_str(), &p);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elP
-            found=buff.find(",");
-            if(found!=string::npos){
-                seqdd[seqscount].elP=strtod(buff.substr(0,found).c_str(), &p);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elQ
-            found=buff.find(",");
-            if(found!=string::npos){
-                seqdd[seqscount].elQ=strtod(buff.substr(0,found).c_str(), &p);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elR
-            found=buff.find(",");
-            if(found!=string::npos){
-                seqdd[seqscount].elR=strtod(buff.substr(0,found).c_str(), &p);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elS
-            found=buff.find(",");
-            if(found!=string::npos){
-                seqdd[seqscount].elS=strtod(buff.substr(0,found).c_str(), &p);
-                buff.assign(buff.substr(found+1));
-            }
-            // Assign elT
-            found=buff.find(",");
-            if(found!=string::npos){
-                seqdd[seqscount].elT=strtod(buff.substr(0,found).c_str(), &p);
-                buff.assign(buff.substr(found+1));
-            }
-            seqd[seqscount].ulist=false;
-            seqscount++;
+    fresh=false;
+    start=phasestart();
+    if(loadsnapshot(infile, st)==false){
+        start=phasestart();
+        if(((archive==true) ? loadarchive(infile, st, nthreads) : loadregina(infile, st, nthreads))==false){
+            info << "\rError reading " << infile << "!!" << endl;
+            return (queries.empty()) ? 0 : 1;
         }
-        seqscount-=1;
+        phaseend(phaseload, start);
+        fresh=true;
     }
-    else{
-        cout << "\rError reading " << infile << "!!" << endl;
-        return 0;
+    else
+        phaseend(phasesnapshot, start);
+    start=phasestart();
+    updated=applyoverlay(infile, st);
+    phaseend(phaseoverlay, start);
+    if(fresh==true || updated>=compactrows){
+        start=phasestart();
+        savesnapshot(infile, st);
+        phaseend(phasesave, start);
     }
 
-    cout << "\rData available for sequences 2 through " << seqscount-1 << endl;
-    cout << "Sequence endings - prime: " << pcount << ", cycle: " << ccount << ", open: " << ocount << endl;
+    info << "\rData available for sequences 2 through " << st.seqscount-1 << endl;
+    info << "Sequence endings - prime: " << st.ends.pcount << ", cycle: " << st.ends.ccount << ", open: " << st.ends.ocount << endl;
+    reportclamps(st, info);
+    if(updated>0)
+        info << updated << " sequences updated from " << infile << ".update" << endl;
+    if(!queries.empty())
+        return (runbatch(st, queries, rangeopt, modopt, output, format, countonly, nthreads)==true) ? 0 : 1;
+    if(serve.length()>0)
+        return (runserver(st, serve, nthreads)==true) ? 0 : 1;
 
     do{
-        cout << "Enter sequence (##/a/h/p/p##/q/u): ";
+        cout << "Enter sequence (##/a/a name/h/p/p##/q/s/u): ";
         getline(cin, seqq);
         if(seqq.substr(0,1)=="q")
             return 0;
         if(seqq.substr(0,1)=="h")
             helptext();
+        else if(settrim(seqq)=="stats")
+            statsreport(cout, false);
         else if(seqq.substr(0,1)=="a"){
-            uselist=false;
-            advanced(seqd, seqdd, seqscount, uselist);
+            temp=settrim(seqq.substr(1));
+            input=NULL;
+            if(temp.length()>0 && (input=findset(sets, last, temp))==NULL)
+                cout << "No set named " << temp << "." << endl;
+            else if(input!=NULL){
+                prev=*input;
+                advanced(st, &prev, last, nthreads);
+            }
+            else
+                advanced(st, NULL, last, nthreads);
         }
+        else if(seqq.substr(0,1)=="s")
+            setcommand(settrim(seqq.substr(1)), sets, last);
         else if(seqq.substr(0,1)=="u")
-            createupdate(seqd);
+            createupdate(st, infile, nthreads);
         else if(seqq.substr(0,1)=="p")
             if(seqq.length()>1){
                 temp.assign(seqq.substr(1));
                 none=true;
-                for(i=2;i<seqscount;i++){
-                    if(temp==seqd[i].elD && seqd[i].elB==1){
+                pid=dictfind(st, temp);
+                nseqs=(pid>=0) ? elDseqs(st, pid, seqs) : 0;
+                for(m=0;m<nseqs;m++){
+                    if(st.elB[seqs[m]]==1){
                         none=false;
-                        primesfind(seqd, seqdd, seqscount, i);
+                        primesfind(st, seqs[m], last, nthreads);
                         break;
                     }
                 }
@@ -862,51 +6132,52 @@ int main(int argv, char *argc[])
                     cout << "No sequences found that terminate with " << temp << "." << endl;
             }
             else
-                primeslist(seqd, seqscount);
+                primeslist(st, nthreads);
         else{
             seqn=atoi(seqq.c_str());
-            if(seqn>1 && seqn<seqscount){
-                if(seqd[seqn].elB==1){
-                    cout << seqn << " terminates with prime " << seqd[seqn].elD << "." << endl;
-                    primesfind(seqd, seqdd, seqscount, seqn);
+            if(seqn>1 && seqn<st.seqscount){
+                dval=dictvalue(st, st.elD[seqn]);
+                if(st.elB[seqn]==1){
+                    cout << seqn << " terminates with prime " << dval << "." << endl;
+                    primesfind(st, seqn, last, nthreads);
                 }
-                else if(seqd[seqn].elB==0){
+                else if(st.elB[seqn]==0){
                     cout << seqn << " is open ended. ";
-                    if(to_string(seqn)==seqd[seqn].elD){
+                    if(to_string(seqn)==dval){
                         cout << "List any sequences that merge with " << seqn << "? (y/n/c/f): ";
                         getline(cin, yn);
                         if(yn.substr(0,1)=="y" || yn.substr(0,1)=="f" || yn.substr(0,1)=="c"){
-                            if(yn.substr(0,1)=="f"){
-                                out.open("results.txt", std::ios_base::app);
-                                out << "All sequences that merge with " << seqd[seqn].elD << ":" << endl;
-                            }
+                            start=phasestart();
+                            if(yn.substr(0,1)=="f" && openwriterfile(fout, "results.txt", true, fmtlines)==true)
+                                writertext(fout, "All sequences that merge with "+string(dval)+":\n");
+                            if(yn!="c")
+                                openwriter(screen, STDOUT_FILENO, false, fmtcolumns);
                             rcount=0;
-                            for(j=seqn+1;j<seqscount;j++){
-                                if(seqd[j].elD==seqd[seqn].elD){
-                                    if(out.is_open())
-                                        out << j << endl;
-                                    temp.assign(to_string(j));
-                                    temp.append("          ");
-                                    temp=temp.substr(0,10);
-                                    if(yn!="c")
-                                        cout << temp;
-                                    seqd[j].ulist=true;
-                                    rcount++;
-                                }
-                                else
-                                    seqd[j].ulist=false;
+                            listed.clear();
+                            nseqs=elDseqs(st, st.elD[seqn], seqs);
+                            for(m=0;m<nseqs;m++){
+                                j=seqs[m];
+                                if(j<=seqn)
+                                    continue;
+                                writerid(fout, j);
+                                writerid(screen, j);
+                                listed.push_back(j);
+                                rcount++;
                             }
-                            if(out.is_open())
-                                out.close();
-                            if(yn!="c")
-                                cout << endl;
+                            last=setfromlist(listed);
+                            writertext(screen, "\n");
+                            closewriter(fout);
+                            closewriter(screen);
+                            perf.scanned+=nseqs;
+                            perf.matched+=rcount;
+                            phaseend(phaselisting, start);
                             if(rcount>1){
                                 cout << rcount << " sequences found." << endl;
                                 cout << "Perform Advanced Filtering on these results? (y/n): ";
                                 getline(cin, yn);
                                 if(yn.substr(0,1)=="y"){
-                                    uselist=true;
-                                    advanced(seqd, seqdd, seqscount, uselist);
+                                    prev=last;
+                                    advanced(st, &prev, last, nthreads);
                                 }
                             }
                             else if(rcount==1)
@@ -916,18 +6187,17 @@ int main(int argv, char *argc[])
                         }
                     }
                     else
-                        cout << "It merges with " << seqd[seqn].elD << "." << endl;
+                        cout << "It merges with " << dval << "." << endl;
                 }
-                else if(seqd[seqn].elB<0){
-                    c=0;
-                    if(seqd[seqn].elD=="6" || seqd[seqn].elD=="28" || seqd[seqn].elD=="496" || seqd[seqn].elD=="8128" || seqd[seqn].elD=="33550336" || seqd[seqn].elD=="8589869056" || seqd[seqn].elD=="137438691328" || seqd[seqn].elD=="2305843008139952128" || seqd[seqn].elD=="2658455991569831744654692615953842176" || seqd[seqn].elD=="191561942608236107294793378084303638130997321548169216"){
+                else if(st.elB[seqn]<0){
+                    if(dval=="6" || dval=="28" || dval=="496" || dval=="8128" || dval=="33550336" || dval=="8589869056" || dval=="137438691328" || dval=="2305843008139952128" || dval=="2658455991569831744654692615953842176" || dval=="191561942608236107294793378084303638130997321548169216"){
                         if(to_string(seqn)=="6" || to_string(seqn)=="28" || to_string(seqn)=="496" || to_string(seqn)=="8128" || to_string(seqn)=="33550336"){
                             cout << seqn << " is a perfect number." << endl;
-                            cout << "Display all sequences that end with " << seqd[seqn].elD << "? (y/n/c/f): ";
+                            cout << "Display all sequences that end with " << dval << "? (y/n/c/f): ";
                         }
                         else{
-                            cout << seqn << " ends with the perfect number " << seqd[seqn].elD << "," << endl;
-                            cout << "Display all sequences that end with " << seqd[seqn].elD << "? (y/n/c/f): ";
+                            cout << seqn << " ends with the perfect number " << dval << "," << endl;
+                            cout << "Display all sequences that end with " << dval << "? (y/n/c/f): ";
                         }
                     }
                     else{
@@ -938,95 +6208,50 @@ int main(int argv, char *argc[])
                                 out.open("results.txt", std::ios_base::app);
                                 out << seqn << " ends with the following cycle:" << endl;
                             }
-                            temp.assign("wget \"http://www.factordb.com/elf.php?seq=");
-                            temp.append(seqd[seqn].elD);
-                            temp.append("&type=1\" -q -O cycle.tmp");
-                            system(temp.c_str());
-                            cyc.open("cycle.tmp");
-                            if(cyc.is_open()){
-                                while(!cyc.eof()){
-                                    getline(cyc, buff);
-                                    foundp=buff.find(".");
-                                    founde=buff.find("=");
-                                    if(founde!=string::npos && foundp!=string::npos){
-                                        cycles[c].assign(buff.substr(foundp+4,founde-foundp-5));
-                                        c++;
-                                    }
-                                }
-                                cyc.close();
-                                c-=2;
-                                for(j=0;j<c;j++){
-                                    if(out.is_open())
-                                        out << cycles[j] << endl;
-                                    cout << cycles[j] << endl;
-                                }
+                            cycles=cyclemembers(st, dval);
+                            for(m=0;m<cycles.size();m++){
                                 if(out.is_open())
-                                    out.close();
+                                    out << cycles[m] << endl;
+                                cout << cycles[m] << endl;
                             }
-                            else
-                                cout << "An error was encountered trying to read cycle.tmp!" << endl;
+                            if(out.is_open())
+                                out.close();
                         }
                         cout << "Display all sequences that end in this cycle? (y/n/c/f): ";
                     }
                     getline(cin, yn);
                     if(yn.substr(0,1)=="y" || yn.substr(0,1)=="f" || yn.substr(0,1)=="c"){
-                        if(yn.substr(0,1)=="f"){
-                            out.open("results.txt", std::ios_base::app);
-                            if(seqd[seqn].elD=="6" || seqd[seqn].elD=="28" || seqd[seqn].elD=="496" || seqd[seqn].elD=="8128" || seqd[seqn].elD=="33550336" || seqd[seqn].elD=="8589869056" || seqd[seqn].elD=="137438691328" || seqd[seqn].elD=="2305843008139952128")
-                                out << "All sequences that end with the perfect number " << seqd[seqn].elD << ":" << endl;
+                        start=phasestart();
+                        if(yn.substr(0,1)=="f" && openwriterfile(fout, "results.txt", true, fmtlines)==true){
+                            if(dval=="6" || dval=="28" || dval=="496" || dval=="8128" || dval=="33550336" || dval=="8589869056" || dval=="137438691328" || dval=="2305843008139952128")
+                                writertext(fout, "All sequences that end with the perfect number "+string(dval)+":\n");
                             else
-                                out << "All sequences that end within the same cycle as " << seqd[seqn].elD << ":" << endl;
+                                writertext(fout, "All sequences that end within the same cycle as "+string(dval)+":\n");
                         }
+                        if(yn!="c")
+                            openwriter(screen, STDOUT_FILENO, false, fmtcolumns);
                         rcount=0;
-                        if(c==0){
-                            temp.assign("wget \"http://www.factordb.com/elf.php?seq=");
-                            temp.append(seqd[seqn].elD);
-                            temp.append("&type=1\" -q -O cycle.tmp");
-                            system(temp.c_str());
-                            cyc.open("cycle.tmp");
-                            if(cyc.is_open()){
-                                while(!cyc.eof()){
-                                    getline(cyc, buff);
-                                    foundp=buff.find(".");
-                                    founde=buff.find("=");
-                                    if(founde!=string::npos && foundp!=string::npos){
-                                        cycles[c].assign(buff.substr(foundp+4,founde-foundp-5));
-                                        c++;
-                                    }
-                                }
-                                cyc.close();
-                                c-=2;
-                            }
-                            else
-                                cout << "An error was encountered trying to read cycle.tmp!" << endl;
-                        }
-                        for(j=2;j<seqscount;j++){
-                            seqd[j].ulist=false;
-                            for(k=0;k<c;k++)
-                                if(cycles[k]==seqd[j].elD){
-                                    if(out.is_open())
-                                        out << j << endl;
-                                    temp.assign(to_string(j));
-                                    temp.append("          ");
-                                    temp=temp.substr(0,10);
-                                    if(yn!="c")
-                                        cout << temp;
-                                    seqd[j].ulist=true;
-                                    rcount++;
-                                }
+                        cycleseqs=cyclesequences(st, dval);
+                        last=setfromlist(cycleseqs);
+                        for(m=0;m<cycleseqs.size();m++){
+                            writerid(fout, cycleseqs[m]);
+                            writerid(screen, cycleseqs[m]);
+                            rcount++;
                         }
-                        if(out.is_open())
-                            out.close();
-                        if(yn!="c")
-                            cout << endl;
+                        writertext(screen, "\n");
+                        closewriter(fout);
+                        closewriter(screen);
+                        perf.scanned+=rcount;
+                        perf.matched+=rcount;
+                        phaseend(phaselisting, start);
                         if(rcount>1 || rcount<1)
                             cout << rcount << " sequences found." << endl;
                         if(rcount>1){
                             cout << "Perform Advanced Filtering on these results? (y/n): ";
                             getline(cin, yn);
                             if(yn.substr(0,1)=="y"){
-                                uselist=true;
-                                advanced(seqd, seqdd, seqscount, uselist);
+                                prev=last;
+                                advanced(st, &prev, last, nthreads);
                             }
                         }
                         else
@@ -1037,7 +6262,7 @@ int main(int argv, char *argc[])
                     cout << "Sequence appears to be incomplete!" << endl;
             }
             else
-                cout << "Value entered is outside current bounds of 2 through " << seqscount-1 << endl;;
+                cout << "Value entered is outside current bounds of 2 through " << st.seqscount-1 << endl;;
         }
 
     }while(seqq.substr(0,1)!="q");